@@ -0,0 +1,175 @@
+#include <GacUI.h>
+#include "X11CairoIncludes.h"
+#include "NativeWindow/Common/MonotonicTime.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <X11/Xlib.h>
+#include <X11/extensions/XTest.h>
+
+using namespace vl;
+using namespace vl::collections;
+using namespace vl::presentation;
+using namespace vl::presentation::theme;
+using namespace vl::presentation::controls;
+using namespace vl::presentation::compositions;
+
+/***********************************************************************
+Benchmark.InputLatency
+
+Moves the pointer inside the window with XTest from a second connection and
+measures the time from XFlush to the MouseMoving callback on the main thread.
+Set BENCHMARK_SAMPLES to change the number of samples (default 1000).
+***********************************************************************/
+
+int main()
+{
+	SetupX11CairoRenderer();
+}
+
+class InputLatencyWindow : public GuiWindow
+{
+private:
+	// GuiControlHost is already a listener of its native window, so the probe is a separate object
+	class MouseProbe : public Object, public INativeWindowListener
+	{
+	public:
+		InputLatencyWindow*		owner;
+
+		MouseProbe(InputLatencyWindow* _owner)
+			:owner(_owner)
+		{
+		}
+
+		void MouseMoving(const NativeWindowMouseInfo& info)override
+		{
+			vuint64_t sent = __atomic_load_n(&owner->sentTime, __ATOMIC_ACQUIRE);
+			if(sent != 0 && __atomic_load_n(&owner->receivedTime, __ATOMIC_ACQUIRE) == 0)
+			{
+				__atomic_store_n(&owner->receivedTime, x11cairo::GetMonotonicTime(), __ATOMIC_RELEASE);
+			}
+		}
+	};
+
+	MouseProbe					probe;
+	vint						sampleCount;
+	vuint64_t					sentTime;
+	vuint64_t					receivedTime;
+	List<vuint64_t>				samples;
+	Thread*						senderThread;
+
+	void Send(Rect bounds)
+	{
+		Display* display = XOpenDisplay(NULL);
+		if(!display)
+		{
+			fprintf(stderr, "Cannot open a second display connection\n");
+			GetApplication()->InvokeInMainThread([=](){ Close(); });
+			return;
+		}
+
+		for(vint i = 0; i < sampleCount; i++)
+		{
+			vint x = bounds.Left() + bounds.Width() / 2 + (i % 2 == 0 ? -10 : 10);
+			vint y = bounds.Top() + bounds.Height() / 2;
+
+			__atomic_store_n(&receivedTime, 0, __ATOMIC_RELEASE);
+			vuint64_t sent = x11cairo::GetMonotonicTime();
+			__atomic_store_n(&sentTime, sent, __ATOMIC_RELEASE);
+			XTestFakeMotionEvent(display, -1, (int)x, (int)y, CurrentTime);
+			XFlush(display);
+
+			//Give up on a sample after one second, e.g. when another window covers this one
+			vuint64_t received = 0;
+			while((received = __atomic_load_n(&receivedTime, __ATOMIC_ACQUIRE)) == 0)
+			{
+				if(x11cairo::GetMonotonicTime() - sent > 1000000) break;
+				usleep(100);
+			}
+			__atomic_store_n(&sentTime, 0, __ATOMIC_RELEASE);
+
+			if(received != 0)
+			{
+				samples.Add(received - sent);
+			}
+		}
+
+		XCloseDisplay(display);
+		GetApplication()->InvokeInMainThread([=](){ Close(); });
+	}
+
+	void Report()
+	{
+		if(samples.Count() == 0)
+		{
+			printf("No input event was dispatched\n");
+			return;
+		}
+
+		Array<vuint64_t> sorted(samples.Count());
+		CopyFrom(sorted, samples);
+		SortLambda(&sorted[0], sorted.Count(), [](vuint64_t a, vuint64_t b){ return a < b ? -1 : a > b ? 1 : 0; });
+
+		vuint64_t total = 0;
+		for(vint i = 0; i < sorted.Count(); i++)
+		{
+			total += sorted[i];
+		}
+
+		printf("samples: %d/%d\n", (int)sorted.Count(), (int)sampleCount);
+		printf("min:     %llu us\n", (unsigned long long)(sorted[0]));
+		printf("average: %llu us\n", (unsigned long long)(total / sorted.Count()));
+		printf("median:  %llu us\n", (unsigned long long)(sorted[sorted.Count() / 2]));
+		printf("p99:     %llu us\n", (unsigned long long)(sorted[sorted.Count() * 99 / 100]));
+		printf("max:     %llu us\n", (unsigned long long)(sorted[sorted.Count() - 1]));
+	}
+
+	void window_WindowOpened(GuiGraphicsComposition* sender, GuiEventArgs& arguments)
+	{
+		GetNativeWindow()->InstallListener(&probe);
+		Rect bounds = GetNativeWindow()->GetClientBoundsInScreen();
+		senderThread = Thread::CreateAndStart([=](){ Send(bounds); }, false);
+	}
+
+	void window_WindowClosed(GuiGraphicsComposition* sender, GuiEventArgs& arguments)
+	{
+		if(senderThread)
+		{
+			senderThread->Wait();
+			delete senderThread;
+			senderThread = 0;
+		}
+		GetNativeWindow()->UninstallListener(&probe);
+		Report();
+	}
+public:
+	InputLatencyWindow()
+		:GuiWindow(GetCurrentTheme()->CreateWindowStyle())
+		,probe(this)
+		,sampleCount(1000)
+		,sentTime(0)
+		,receivedTime(0)
+		,senderThread(0)
+	{
+		this->SetText(L"Benchmark.InputLatency");
+		this->SetClientSize(Size(320, 240));
+		this->MoveToScreenCenter();
+
+		if(const char* value = getenv("BENCHMARK_SAMPLES"))
+		{
+			vint count = atoi(value);
+			if(count > 0) sampleCount = count;
+		}
+
+		this->WindowOpened.AttachMethod(this, &InputLatencyWindow::window_WindowOpened);
+		this->WindowClosed.AttachMethod(this, &InputLatencyWindow::window_WindowClosed);
+	}
+};
+
+void GuiMain()
+{
+	GuiWindow* window = new InputLatencyWindow();
+	GetApplication()->Run(window);
+	delete window;
+}
@@ -0,0 +1,159 @@
+#include <GacUI.h>
+#include "X11CairoIncludes.h"
+#include "NativeWindow/Common/MonotonicTime.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace vl;
+using namespace vl::collections;
+using namespace vl::presentation;
+using namespace vl::presentation::theme;
+using namespace vl::presentation::controls;
+using namespace vl::presentation::compositions;
+
+/***********************************************************************
+Benchmark.InvokeRoundTrip
+
+Worker threads call InvokeInMainThreadAndWait with an empty task and measure
+each round trip, from posting the task to returning from the call.
+Set BENCHMARK_SAMPLES (default 10000 per thread) and BENCHMARK_THREADS
+(default 1) to change the load.
+***********************************************************************/
+
+int main()
+{
+	SetupX11CairoRenderer();
+}
+
+namespace
+{
+	vint GetEnvironmentCount(const char* name, vint defaultValue)
+	{
+		if(const char* value = getenv(name))
+		{
+			vint count = atoi(value);
+			if(count > 0) return count;
+		}
+		return defaultValue;
+	}
+}
+
+class InvokeRoundTripWindow : public GuiWindow
+{
+private:
+	vint						sampleCount;
+	vint						threadCount;
+	Array<Ptr<List<vuint64_t>>>	samples;
+	List<Thread*>				threads;
+	vint						runningThreads;
+	vint						failedCount;
+	vuint64_t					startTime;
+	vuint64_t					elapsedTime;
+
+	void Measure(vint index)
+	{
+		List<vuint64_t>& threadSamples = *samples[index].Obj();
+		for(vint i = 0; i < sampleCount; i++)
+		{
+			vuint64_t begin = x11cairo::GetMonotonicTime();
+			if(GetApplication()->InvokeInMainThreadAndWait([](){}, 1000))
+			{
+				threadSamples.Add(x11cairo::GetMonotonicTime() - begin);
+			}
+			else
+			{
+				__atomic_add_fetch(&failedCount, 1, __ATOMIC_RELAXED);
+			}
+		}
+
+		if(__atomic_sub_fetch(&runningThreads, 1, __ATOMIC_ACQ_REL) == 0)
+		{
+			elapsedTime = x11cairo::GetMonotonicTime() - startTime;
+			GetApplication()->InvokeInMainThread([=](){ Close(); });
+		}
+	}
+
+	void Report()
+	{
+		List<vuint64_t> merged;
+		for(vint i = 0; i < samples.Count(); i++)
+		{
+			CopyFrom(merged, *samples[i].Obj(), true);
+		}
+		if(merged.Count() == 0)
+		{
+			printf("No task finished\n");
+			return;
+		}
+
+		Array<vuint64_t> sorted(merged.Count());
+		CopyFrom(sorted, merged);
+		SortLambda(&sorted[0], sorted.Count(), [](vuint64_t a, vuint64_t b){ return a < b ? -1 : a > b ? 1 : 0; });
+
+		vuint64_t total = 0;
+		for(vint i = 0; i < sorted.Count(); i++)
+		{
+			total += sorted[i];
+		}
+
+		printf("threads:    %d\n", (int)threadCount);
+		printf("calls:      %d (%d timed out)\n", (int)sorted.Count(), (int)failedCount);
+		printf("throughput: %.0f calls/s\n", elapsedTime > 0 ? sorted.Count() * 1000000.0 / elapsedTime : 0.0);
+		printf("min:        %llu us\n", (unsigned long long)sorted[0]);
+		printf("average:    %llu us\n", (unsigned long long)(total / sorted.Count()));
+		printf("median:     %llu us\n", (unsigned long long)sorted[sorted.Count() / 2]);
+		printf("p99:        %llu us\n", (unsigned long long)sorted[sorted.Count() * 99 / 100]);
+		printf("max:        %llu us\n", (unsigned long long)sorted[sorted.Count() - 1]);
+	}
+
+	void window_WindowOpened(GuiGraphicsComposition* sender, GuiEventArgs& arguments)
+	{
+		runningThreads = threadCount;
+		startTime = x11cairo::GetMonotonicTime();
+		for(vint i = 0; i < threadCount; i++)
+		{
+			threads.Add(Thread::CreateAndStart([=](){ Measure(i); }, false));
+		}
+	}
+
+	void window_WindowClosed(GuiGraphicsComposition* sender, GuiEventArgs& arguments)
+	{
+		FOREACH(Thread*, thread, threads)
+		{
+			thread->Wait();
+			delete thread;
+		}
+		threads.Clear();
+		Report();
+	}
+public:
+	InvokeRoundTripWindow()
+		:GuiWindow(GetCurrentTheme()->CreateWindowStyle())
+		,sampleCount(GetEnvironmentCount("BENCHMARK_SAMPLES", 10000))
+		,threadCount(GetEnvironmentCount("BENCHMARK_THREADS", 1))
+		,runningThreads(0)
+		,failedCount(0)
+		,startTime(0)
+		,elapsedTime(0)
+	{
+		this->SetText(L"Benchmark.InvokeRoundTrip");
+		this->SetClientSize(Size(320, 240));
+		this->MoveToScreenCenter();
+		samples.Resize(threadCount);
+		for(vint i = 0; i < threadCount; i++)
+		{
+			samples.Set(i, new List<vuint64_t>);
+		}
+
+		this->WindowOpened.AttachMethod(this, &InvokeRoundTripWindow::window_WindowOpened);
+		this->WindowClosed.AttachMethod(this, &InvokeRoundTripWindow::window_WindowClosed);
+	}
+};
+
+void GuiMain()
+{
+	GuiWindow* window = new InvokeRoundTripWindow();
+	GetApplication()->Run(window);
+	delete window;
+}
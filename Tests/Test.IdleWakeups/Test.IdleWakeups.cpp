@@ -0,0 +1,115 @@
+#include <GacUI.h>
+#include "X11CairoIncludes.h"
+#include "NativeWindow/Xlib/ServicesImpl/XlibNativeWindowService.h"
+#include "NativeWindow/Xlib/ServicesImpl/XlibNativeInputService.h"
+
+#include <stdio.h>
+
+using namespace vl;
+using namespace vl::presentation;
+using namespace vl::presentation::theme;
+using namespace vl::presentation::controls;
+using namespace vl::presentation::compositions;
+using namespace vl::presentation::x11cairo;
+using namespace vl::presentation::x11cairo::xlib;
+
+/***********************************************************************
+Test.IdleWakeups
+
+Measures how often the event loop wakes up and the global timer ticks while
+the application is idle. The process exits with 1 when a rate is too high:
+  - idle with a delay pending far in the future, the timer must stay suspended
+  - idle with a caret, the timer ticks at the caret rate instead of the full rate
+***********************************************************************/
+
+static int testResult = 0;
+
+int main()
+{
+	SetupX11CairoRenderer();
+	return testResult;
+}
+
+class IdleWakeupsWindow : public GuiWindow
+{
+private:
+	static const vint			IdleTimeout = 100;
+	static const vint			MeasureTime = 3000;
+
+	XlibNativeWindowService*	windowService;
+	XlibNativeInputService*		inputService;
+	Ptr<INativeDelay>			pendingDelay;
+	vuint64_t					startWakeups;
+	vuint64_t					startTicks;
+
+	//Starting a phase is a task itself, which keeps the timer ticking for IdleTimeout
+	void Measure(const wchar_t* name, double maxWakeups, double minTicks, double maxTicks, const Func<void()>& next)
+	{
+		startWakeups = windowService->GetWakeupCount();
+		startTicks = inputService->GetTimerTickCount();
+		GetApplication()->DelayExecuteInMainThread([=]()
+		{
+			double seconds = MeasureTime / 1000.0;
+			double wakeups = (windowService->GetWakeupCount() - startWakeups) / seconds;
+			double ticks = (inputService->GetTimerTickCount() - startTicks) / seconds;
+			bool passed = wakeups <= maxWakeups && ticks >= minTicks && ticks <= maxTicks;
+			if(!passed) testResult = 1;
+
+			wprintf(L"%ls %ls: %.1f wakeups/s (at most %.1f), %.1f ticks/s (%.1f to %.1f)\n",
+				passed ? L"PASS" : L"FAIL", name, wakeups, maxWakeups, ticks, minTicks, maxTicks);
+			next();
+		}, MeasureTime);
+	}
+
+	void window_WindowOpened(GuiGraphicsComposition* sender, GuiEventArgs& arguments)
+	{
+		windowService = dynamic_cast<XlibNativeWindowService*>(GetCurrentController()->WindowService());
+		inputService = dynamic_cast<XlibNativeInputService*>(GetCurrentController()->InputService());
+		if(!windowService || !inputService)
+		{
+			wprintf(L"FAIL: the Xlib services are not in use\n");
+			testResult = 1;
+			Close();
+			return;
+		}
+
+		inputService->SetTimerIdleTimeout(IdleTimeout);
+		pendingDelay = GetApplication()->DelayExecuteInMainThread([](){}, 60000);
+
+		vint rate = inputService->GetTimerRate();
+		double caretRate = 1000000.0 / XlibNativeInputService::CaretTimerInterval;
+		double settle = IdleTimeout / 1000.0 * rate / (MeasureTime / 1000.0);
+		GetApplication()->DelayExecuteInMainThread([=]()
+		{
+			Measure(L"idle with a pending delay", settle + 2, 0, settle + 1, [=]()
+			{
+				GetNativeWindow()->SetCaretPoint(Point(0, 0));
+				Measure(L"idle with a caret", caretRate + settle + 2, caretRate - 1, caretRate + settle + 1, [=]()
+				{
+					pendingDelay->Cancel();
+					Close();
+				});
+			});
+		}, 500);
+	}
+public:
+	IdleWakeupsWindow()
+		:GuiWindow(GetCurrentTheme()->CreateWindowStyle())
+		,windowService(0)
+		,inputService(0)
+		,startWakeups(0)
+		,startTicks(0)
+	{
+		this->SetText(L"Test.IdleWakeups");
+		this->SetClientSize(Size(320, 240));
+		this->MoveToScreenCenter();
+		this->WindowOpened.AttachMethod(this, &IdleWakeupsWindow::window_WindowOpened);
+	}
+};
+
+void GuiMain()
+{
+	GuiWindow* window = new IdleWakeupsWindow();
+	GetApplication()->Run(window);
+	delete window;
+}
@@ -5,15 +5,175 @@ namespace vl
 {
 	namespace presentation
 	{
+		namespace elements
+		{
+
+/***********************************************************************
+GuiX11CairoElement
+***********************************************************************/
+
+			GuiX11CairoElement::GuiX11CairoElement():
+				cached(false)
+			{
+			}
+
+			GuiX11CairoElement::~GuiX11CairoElement()
+			{
+			}
+
+			bool GuiX11CairoElement::GetCached()
+			{
+				return cached;
+			}
+
+			void GuiX11CairoElement::SetCached(bool value)
+			{
+				if(cached != value)
+				{
+					cached = value;
+					if(renderer)
+					{
+						renderer->OnElementStateChanged();
+					}
+				}
+			}
+
+			void GuiX11CairoElement::InvalidateCache()
+			{
+				if(renderer)
+				{
+					renderer->OnElementStateChanged();
+				}
+			}
+		}
+
 		namespace elements_x11cairo
 		{
+
+/***********************************************************************
+GuiX11CairoElementRenderer
+***********************************************************************/
+
+			GuiX11CairoElementRenderer::GuiX11CairoElementRenderer():
+				minSize(0, 0), cairoContext(NULL), cacheSurface(NULL), cacheDirty(true)
+			{
+			}
+
+			void GuiX11CairoElementRenderer::ReleaseCache()
+			{
+				if(cacheSurface)
+				{
+					cairo_surface_destroy(cacheSurface);
+					cacheSurface = NULL;
+				}
+				cacheDirty = true;
+			}
+
+			void GuiX11CairoElementRenderer::InitializeInternal()
+			{
+			}
+
+			void GuiX11CairoElementRenderer::FinalizeInternal()
+			{
+				ReleaseCache();
+			}
+
+			void GuiX11CairoElementRenderer::Render(Rect bounds)
+			{
+				lastBounds = bounds;
+				if(!renderTarget || bounds.Width() <= 0 || bounds.Height() <= 0) return;
+
+				renderTarget->PushClipper(bounds);
+				Rect clipper = renderTarget->GetClipper();
+				if(clipper.Width() > 0 && clipper.Height() > 0)
+				{
+					if(element->GetCached())
+					{
+						//A frame rasterizing on a worker may still read the old cache
+						if(cacheSurface && (cacheSize != bounds.GetSize() || (cacheDirty && renderTarget->GetParallelRendering())))
+						{
+							ReleaseCache();
+						}
+
+						if(!cacheSurface)
+						{
+							cacheSize = bounds.GetSize();
+							cacheSurface = renderTarget->CreateCacheSurface(cacheSize);
+						}
+
+						if(cacheDirty)
+						{
+							cairo_t* cacheContext = cairo_create(cacheSurface);
+							cairo_set_operator(cacheContext, CAIRO_OPERATOR_CLEAR);
+							cairo_paint(cacheContext);
+							cairo_set_operator(cacheContext, CAIRO_OPERATOR_OVER);
+
+							GuiX11CairoElementEventArgs arguments(element, cacheContext, Rect(Point(0, 0), cacheSize));
+							element->Rendering.Execute(arguments);
+							cairo_destroy(cacheContext);
+							cacheDirty = false;
+						}
+
+						cairo_set_source_surface(cairoContext, cacheSurface, bounds.x1, bounds.y1);
+						cairo_paint(cairoContext);
+					}
+					else
+					{
+						cairo_save(cairoContext);
+						GuiX11CairoElementEventArgs arguments(element, cairoContext, bounds);
+						element->Rendering.Execute(arguments);
+						cairo_restore(cairoContext);
+					}
+				}
+				renderTarget->PopClipper();
+			}
+
+			void GuiX11CairoElementRenderer::OnElementStateChanged()
+			{
+				if(element->GetCached())
+				{
+					cacheDirty = true;
+				}
+				else
+				{
+					ReleaseCache();
+				}
+
+				if(renderTarget && lastBounds.Width() > 0 && lastBounds.Height() > 0)
+				{
+					renderTarget->Invalidate(lastBounds);
+				}
+			}
+
+			void GuiX11CairoElementRenderer::RenderTargetChangedInternal(IX11CairoRenderTarget* oldRT, IX11CairoRenderTarget* newRT)
+			{
+				GuiX11CairoElementEventArgs before(element, cairoContext, Rect());
+				element->BeforeRenderTargetChanged.Execute(before);
+
+				ReleaseCache();
+				if(newRT)
+					cairoContext = newRT->GetCairoContext();
+				else cairoContext = NULL;
+
+				GuiX11CairoElementEventArgs after(element, cairoContext, Rect());
+				element->AfterRenderTargetChanged.Execute(after);
+			}
+
 			void RegisterX11CairoElementRenderers()
 			{
 				GuiSolidBackgroundElementRenderer::Register();
 				GuiSolidLabelElementRenderer::Register();
 				GuiSolidBorderElementRenderer::Register();
+				GuiRoundBorderElementRenderer::Register();
+				Gui3DBorderElementRenderer::Register();
+				Gui3DSplitterElementRenderer::Register();
+				GuiFocusRectangleElementRenderer::Register();
 				GuiGradientBackgroundElementRenderer::Register();
 				GuiPolygonElementRenderer::Register();
+				GuiColorizedTextElementRenderer::Register();
+				GuiImageFrameElementRenderer::Register();
+				GuiDocumentElement::GuiDocumentElementRenderer::Register();
+				GuiX11CairoElementRenderer::Register();
 			}
 		}
 	}
@@ -17,7 +17,15 @@ namespace vl
 			{
 			public:
 				GuiX11CairoElement* element;
+				//The context to draw on, NULL in render target change notifications when there is no new target
+				cairo_t* context;
+				//The area to draw, in the coordinates of context
+				Rect bounds;
 
+				GuiX11CairoElementEventArgs(GuiX11CairoElement* _element, cairo_t* _context, Rect _bounds):
+					element(_element), context(_context), bounds(_bounds)
+				{
+				}
 			};
 
 			class GuiX11CairoElement: public Object, public elements::IGuiGraphicsElement, public Description<GuiX11CairoElement>
@@ -25,10 +33,48 @@ namespace vl
 				DEFINE_GUI_GRAPHICS_ELEMENT(GuiX11CairoElement, L"X11CairoElement");
 
 			protected:
+				bool cached;
+
 				GuiX11CairoElement();
 
 			public:
 				~GuiX11CairoElement();
+
+				compositions::GuiGraphicsEvent<GuiX11CairoElementEventArgs> BeforeRenderTargetChanged;
+				compositions::GuiGraphicsEvent<GuiX11CairoElementEventArgs> AfterRenderTargetChanged;
+				compositions::GuiGraphicsEvent<GuiX11CairoElementEventArgs> Rendering;
+
+				//When cached, Rendering draws into an offscreen surface that is reused by every
+				//later paint, until InvalidateCache is called or the element is resized
+				bool GetCached();
+				void SetCached(bool value);
+				void InvalidateCache();
+			};
+		}
+		namespace elements_x11cairo
+		{
+			using namespace elements;
+			class GuiX11CairoElementRenderer: public Object, public IGuiGraphicsRenderer
+			{
+				DEFINE_GUI_GRAPHICS_RENDERER(GuiX11CairoElement, GuiX11CairoElementRenderer, IX11CairoRenderTarget);
+
+			protected:
+				cairo_t* cairoContext;
+				cairo_surface_t* cacheSurface;
+				Size cacheSize;
+				bool cacheDirty;
+				Rect lastBounds;
+
+				void ReleaseCache();
+
+			public:
+				GuiX11CairoElementRenderer();
+
+				void InitializeInternal();
+				void FinalizeInternal();
+				void Render(Rect bounds);
+				void OnElementStateChanged();
+				void RenderTargetChangedInternal(IX11CairoRenderTarget* oldRT, IX11CairoRenderTarget* newRT);
 			};
 		}
 		namespace elements_x11cairo
@@ -1,5 +1,6 @@
 #include <math.h>
 #include "CairoHelpers.h"
+#include "../X11CairoFontWarmUp.h"
 
 namespace vl
 {
@@ -117,6 +118,82 @@ namespace vl
 					}
 					return WString(result);
 				}
+
+				PangoFontDescription* CreateFontDescription(const FontProperties& font)
+				{
+					PangoFontDescription* desc = pango_font_description_new();
+
+					AString family = wtoa(font.fontFamily);
+					pango_font_description_set_family(desc, family.Buffer());
+					pango_font_description_set_absolute_size(desc, font.size * PANGO_SCALE);
+					pango_font_description_set_style(desc, font.italic ? PANGO_STYLE_ITALIC : PANGO_STYLE_NORMAL);
+					pango_font_description_set_weight(desc, font.bold ? PANGO_WEIGHT_BOLD : PANGO_WEIGHT_MEDIUM);
+
+					return desc;
+				}
+
+				PangoContext* CreatePangoContext(cairo_t* cairoContext)
+				{
+					PangoContext* context = pango_font_map_create_context(GetX11CairoFontMap());
+					if(cairoContext)
+					{
+						pango_cairo_update_context(cairoContext, context);
+					}
+					return context;
+				}
+
+				PangoLayout* CreatePangoLayout(cairo_t* cairoContext)
+				{
+					PangoContext* context = CreatePangoContext(cairoContext);
+					PangoLayout* layout = pango_layout_new(context);
+					g_object_unref(context);
+					return layout;
+				}
+
+				AString WStringToUtf8(const wchar_t* text, vint length, collections::Array<vint>* offsets)
+				{
+					collections::Array<char> buffer(length * 4 + 1);
+					if(offsets) offsets->Resize(length + 1);
+
+					vint size = 0;
+					for(vint i = 0; i < length; i++)
+					{
+						if(offsets) (*offsets)[i] = size;
+
+						vuint32_t c = (vuint32_t)text[i];
+						if(c >= 0x110000 || (c >= 0xD800 && c < 0xE000))
+						{
+							c = 0xFFFD;
+						}
+
+						if(c < 0x80)
+						{
+							buffer[size++] = (char)c;
+						}
+						else if(c < 0x800)
+						{
+							buffer[size++] = (char)(0xC0 | (c >> 6));
+							buffer[size++] = (char)(0x80 | (c & 0x3F));
+						}
+						else if(c < 0x10000)
+						{
+							buffer[size++] = (char)(0xE0 | (c >> 12));
+							buffer[size++] = (char)(0x80 | ((c >> 6) & 0x3F));
+							buffer[size++] = (char)(0x80 | (c & 0x3F));
+						}
+						else
+						{
+							buffer[size++] = (char)(0xF0 | (c >> 18));
+							buffer[size++] = (char)(0x80 | ((c >> 12) & 0x3F));
+							buffer[size++] = (char)(0x80 | ((c >> 6) & 0x3F));
+							buffer[size++] = (char)(0x80 | (c & 0x3F));
+						}
+					}
+
+					if(offsets) (*offsets)[length] = size;
+					buffer[size] = 0;
+					return AString(&buffer[0], size);
+				}
 			}
 		}
 	}
@@ -34,6 +34,14 @@ namespace vl
 				void GradientFill(cairo_t* cairoContext, Color color1, Color color2, Rect bounds, GradientDirection direction, bool smooth = false);
 
 				WString WebdingsMap(WString oldString);
+
+				PangoFontDescription* CreateFontDescription(const FontProperties& font);
+
+				//On the font map warmed up in the background, cairoContext may be NULL
+				PangoContext* CreatePangoContext(cairo_t* cairoContext);
+				PangoLayout* CreatePangoLayout(cairo_t* cairoContext);
+
+				AString WStringToUtf8(const wchar_t* text, vint length, collections::Array<vint>* offsets = NULL);
 			}
 		}
 	}
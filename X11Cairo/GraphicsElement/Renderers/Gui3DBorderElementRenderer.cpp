@@ -0,0 +1,55 @@
+#include "Gui3DBorderElementRenderer.h"
+#include "CairoHelpers.h"
+
+namespace vl
+{
+	namespace presentation
+	{
+		namespace elements_x11cairo
+		{
+			Gui3DBorderElementRenderer::Gui3DBorderElementRenderer():
+				minSize(1, 1), cairoContext(NULL)
+			{
+			}
+
+			void Gui3DBorderElementRenderer::InitializeInternal()
+			{
+			}
+
+			void Gui3DBorderElementRenderer::FinalizeInternal()
+			{
+			}
+
+			void Gui3DBorderElementRenderer::Render(Rect bounds)
+			{
+				if(!cairoContext || bounds.Width() <= 0 || bounds.Height() <= 0) return;
+
+				cairo_save(cairoContext);
+				cairo_set_antialias(cairoContext, CAIRO_ANTIALIAS_NONE);
+
+				//Top and left edges
+				cairo_rectangle(cairoContext, bounds.x1, bounds.y1, bounds.Width(), 1);
+				cairo_rectangle(cairoContext, bounds.x1, bounds.y1 + 1, 1, bounds.Height() - 1);
+				helpers::SolidFill(cairoContext, element->GetColor1());
+
+				//Right and bottom edges, drawn over the top and left ones like the GDI renderer does
+				cairo_rectangle(cairoContext, bounds.x2 - 1, bounds.y1, 1, bounds.Height());
+				cairo_rectangle(cairoContext, bounds.x1, bounds.y2 - 1, bounds.Width() - 1, 1);
+				helpers::SolidFill(cairoContext, element->GetColor2());
+
+				cairo_restore(cairoContext);
+			}
+
+			void Gui3DBorderElementRenderer::OnElementStateChanged()
+			{
+			}
+
+			void Gui3DBorderElementRenderer::RenderTargetChangedInternal(IX11CairoRenderTarget* oldRT, IX11CairoRenderTarget* newRT)
+			{
+				if(newRT)
+					cairoContext = newRT->GetCairoContext();
+				else cairoContext = NULL;
+			}
+		}
+	}
+}
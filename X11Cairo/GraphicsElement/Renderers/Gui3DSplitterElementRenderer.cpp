@@ -0,0 +1,69 @@
+#include "Gui3DSplitterElementRenderer.h"
+#include "CairoHelpers.h"
+
+namespace vl
+{
+	namespace presentation
+	{
+		namespace elements_x11cairo
+		{
+			Gui3DSplitterElementRenderer::Gui3DSplitterElementRenderer():
+				minSize(1, 1), cairoContext(NULL)
+			{
+			}
+
+			void Gui3DSplitterElementRenderer::InitializeInternal()
+			{
+			}
+
+			void Gui3DSplitterElementRenderer::FinalizeInternal()
+			{
+			}
+
+			void Gui3DSplitterElementRenderer::Render(Rect bounds)
+			{
+				if(!cairoContext || bounds.Width() <= 0 || bounds.Height() <= 0) return;
+
+				Rect bounds1, bounds2;
+				switch(element->GetDirection())
+				{
+					case Gui3DSplitterElement::Horizontal:
+						{
+							vint y = bounds.y1 + bounds.Height() / 2 - 1;
+							bounds1 = Rect(bounds.x1, y, bounds.x2, y + 1);
+							bounds2 = Rect(bounds.x1, y + 1, bounds.x2, y + 2);
+						}
+						break;
+					case Gui3DSplitterElement::Vertical:
+						{
+							vint x = bounds.x1 + bounds.Width() / 2 - 1;
+							bounds1 = Rect(x, bounds.y1, x + 1, bounds.y2);
+							bounds2 = Rect(x + 1, bounds.y1, x + 2, bounds.y2);
+						}
+						break;
+				}
+
+				cairo_save(cairoContext);
+				cairo_set_antialias(cairoContext, CAIRO_ANTIALIAS_NONE);
+
+				cairo_rectangle(cairoContext, bounds1.x1, bounds1.y1, bounds1.Width(), bounds1.Height());
+				helpers::SolidFill(cairoContext, element->GetColor1());
+				cairo_rectangle(cairoContext, bounds2.x1, bounds2.y1, bounds2.Width(), bounds2.Height());
+				helpers::SolidFill(cairoContext, element->GetColor2());
+
+				cairo_restore(cairoContext);
+			}
+
+			void Gui3DSplitterElementRenderer::OnElementStateChanged()
+			{
+			}
+
+			void Gui3DSplitterElementRenderer::RenderTargetChangedInternal(IX11CairoRenderTarget* oldRT, IX11CairoRenderTarget* newRT)
+			{
+				if(newRT)
+					cairoContext = newRT->GetCairoContext();
+				else cairoContext = NULL;
+			}
+		}
+	}
+}
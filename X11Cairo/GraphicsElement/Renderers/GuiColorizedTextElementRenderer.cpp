@@ -0,0 +1,412 @@
+#include "GuiColorizedTextElementRenderer.h"
+#include "CairoHelpers.h"
+#include "../X11CairoResourceManager.h"
+
+using namespace vl::collections;
+using namespace vl::presentation::elements::text;
+namespace vl
+{
+	namespace presentation
+	{
+		namespace elements_x11cairo
+		{
+			GuiColorizedTextElementRenderer::GlyphRun::GlyphRun()
+				: colorIndex(0), layout(NULL), layoutX(0), layoutY(0)
+			{
+			}
+
+			GuiColorizedTextElementRenderer::GlyphRun::~GlyphRun()
+			{
+				if(layout) g_object_unref(layout);
+			}
+
+			GuiColorizedTextElementRenderer::GuiColorizedTextElementRenderer()
+				: minSize(1, 1), cairoContext(NULL), pangoFontDesc(NULL), frame(0)
+			{
+			}
+
+			void GuiColorizedTextElementRenderer::InitializeInternal()
+			{
+				element->SetCallback(this);
+				FontChanged();
+			}
+
+			void GuiColorizedTextElementRenderer::FinalizeInternal()
+			{
+				lineCaches.Clear();
+				glyphTable = NULL;
+				charMeasurer = NULL;
+
+				if(pangoFontDesc)
+				{
+					pango_font_description_free(pangoFontDesc);
+					pangoFontDesc = NULL;
+				}
+			}
+
+			void GuiColorizedTextElementRenderer::FontChanged()
+			{
+				FontProperties font = element->GetFont();
+				if(pangoFontDesc) pango_font_description_free(pangoFontDesc);
+				pangoFontDesc = helpers::CreateFontDescription(font);
+
+				glyphTable = x11cairo::GetX11CairoResourceManager()->GetGlyphTable(cairoContext, font);
+				charMeasurer = x11cairo::GetX11CairoResourceManager()->GetCharMeasurer(font);
+				element->GetLines().SetCharMeasurer(charMeasurer.Obj());
+
+				lineCaches.Clear();
+			}
+
+			void GuiColorizedTextElementRenderer::ColorChanged()
+			{
+				//Runs only keep color indices, colors are resolved when drawing
+			}
+
+			vint GuiColorizedTextElementRenderer::HashLine(TextLine& line, wchar_t passwordChar)
+			{
+				vuint64_t hash = 14695981039346656037ULL;
+				for(vint i = 0; i < line.dataLength; i++)
+				{
+					hash = (hash ^ (vuint64_t)line.text[i]) * 1099511628211ULL;
+					hash = (hash ^ (vuint64_t)line.att[i].colorIndex) * 1099511628211ULL;
+				}
+				hash = (hash ^ (vuint64_t)passwordChar) * 1099511628211ULL;
+				return (vint)hash;
+			}
+
+			bool GuiColorizedTextElementRenderer::IsLineCacheValid(LineCache* cache, TextLine& line, wchar_t passwordChar)
+			{
+				if(cache->passwordChar != passwordChar || cache->text.Count() != line.dataLength) return false;
+				for(vint i = 0; i < line.dataLength; i++)
+				{
+					if(cache->text[i] != line.text[i] || cache->colorIndices[i] != line.att[i].colorIndex) return false;
+				}
+				return true;
+			}
+
+			Ptr<GuiColorizedTextElementRenderer::LineCache> GuiColorizedTextElementRenderer::BuildLineCache(TextLine& line, wchar_t passwordChar)
+			{
+				Ptr<LineCache> cache = new LineCache;
+				cache->text.Resize(line.dataLength);
+				cache->colorIndices.Resize(line.dataLength);
+				cache->passwordChar = passwordChar;
+				cache->lastFrame = frame;
+
+				Array<wchar_t> display(line.dataLength + 1);
+				for(vint i = 0; i < line.dataLength; i++)
+				{
+					cache->text[i] = line.text[i];
+					cache->colorIndices[i] = line.att[i].colorIndex;
+					display[i] = passwordChar ? passwordChar : line.text[i];
+				}
+
+				double baseline = glyphTable->GetBaseline();
+				List<cairo_glyph_t> runGlyphs;
+				vint runStart = -1;
+				bool runIsLayout = false;
+
+				//Consecutive characters of the same color are grouped into one run,
+				//characters outside of the glyph table are shaped by Pango instead
+				auto flushRun = [&](vint runEnd)
+				{
+					if(runStart == -1) return;
+
+					Ptr<GlyphRun> run = new GlyphRun;
+					run->colorIndex = line.att[runStart].colorIndex;
+					if(runIsLayout)
+					{
+						AString text = helpers::WStringToUtf8(&display[runStart], runEnd - runStart);
+						run->layout = helpers::CreatePangoLayout(cairoContext);
+						pango_layout_set_font_description(run->layout, pangoFontDesc);
+						pango_layout_set_text(run->layout, text.Buffer(), text.Length());
+						run->layoutX = runStart == 0 ? 0 : line.att[runStart - 1].rightOffset;
+						run->layoutY = baseline - (double)pango_layout_get_baseline(run->layout) / PANGO_SCALE;
+					}
+					else
+					{
+						run->glyphs.Resize(runGlyphs.Count());
+						for(vint i = 0; i < runGlyphs.Count(); i++)
+						{
+							run->glyphs[i] = runGlyphs[i];
+						}
+						runGlyphs.Clear();
+					}
+					cache->runs.Add(run);
+					runStart = -1;
+				};
+
+				for(vint i = 0; i < line.dataLength; i++)
+				{
+					//Tabs and other control characters only take space
+					if(display[i] < L' ')
+					{
+						flushRun(i);
+						continue;
+					}
+
+					unsigned long glyph = 0;
+					bool isGlyph = glyphTable->GetGlyph(display[i], glyph);
+					if(runStart != -1 && (runIsLayout == isGlyph || line.att[runStart].colorIndex != line.att[i].colorIndex))
+					{
+						flushRun(i);
+					}
+
+					if(runStart == -1)
+					{
+						runStart = i;
+						runIsLayout = !isGlyph;
+					}
+
+					if(isGlyph)
+					{
+						cairo_glyph_t item;
+						item.index = glyph;
+						item.x = i == 0 ? 0 : line.att[i - 1].rightOffset;
+						item.y = baseline;
+						runGlyphs.Add(item);
+					}
+				}
+				flushRun(line.dataLength);
+
+				return cache;
+			}
+
+			GuiColorizedTextElementRenderer::LineCache* GuiColorizedTextElementRenderer::GetLineCache(TextLine& line, wchar_t passwordChar)
+			{
+				//Caches are keyed by content, so inserting or removing lines does not invalidate the lines after them
+				vint hash = HashLine(line, passwordChar);
+				vint index = lineCaches.Keys().IndexOf(hash);
+				if(index != -1)
+				{
+					LineCache* cache = lineCaches.Values().Get(index).Obj();
+					if(IsLineCacheValid(cache, line, passwordChar))
+					{
+						cache->lastFrame = frame;
+						return cache;
+					}
+					lineCaches.Remove(hash);
+				}
+
+				Ptr<LineCache> cache = BuildLineCache(line, passwordChar);
+				lineCaches.Add(hash, cache);
+				return cache.Obj();
+			}
+
+			void GuiColorizedTextElementRenderer::EvictLineCaches(vint visibleRows)
+			{
+				//Lines scrolled out of view are kept for a while so that scrolling back is cheap
+				if(lineCaches.Count() <= visibleRows * 4 + 64) return;
+
+				List<vint> keys;
+				for(vint i = 0; i < lineCaches.Count(); i++)
+				{
+					if(lineCaches.Values().Get(i)->lastFrame != frame)
+					{
+						keys.Add(lineCaches.Keys().Get(i));
+					}
+				}
+
+				FOREACH(vint, key, keys)
+				{
+					lineCaches.Remove(key);
+				}
+			}
+
+			void GuiColorizedTextElementRenderer::RenderLineText(LineCache* cache, vint x, vint y, vint viewX1, vint viewX2, bool selected)
+			{
+				const GuiColorizedTextElement::ColorArray& colors = element->GetColors();
+				bool focused = element->GetFocused();
+				vint margin = glyphTable->GetHeight() * 2;
+
+				cairo_save(cairoContext);
+				cairo_translate(cairoContext, x, y);
+				cairo_set_scaled_font(cairoContext, glyphTable->GetScaledFont());
+
+				FOREACH(Ptr<GlyphRun>, run, cache->runs)
+				{
+					vint colorIndex = run->colorIndex < colors.Count() ? run->colorIndex : 0;
+					const ColorEntry& entry = colors[colorIndex];
+					Color color = !selected ? entry.normal.text : focused ? entry.selectedFocused.text : entry.selectedUnfocused.text;
+					if(color.a == 0) continue;
+
+					helpers::ColorSet(cairoContext, color);
+					if(run->layout)
+					{
+						if(run->layoutX > viewX2 + margin) continue;
+						cairo_move_to(cairoContext, run->layoutX, run->layoutY);
+						pango_cairo_show_layout(cairoContext, run->layout);
+					}
+					else
+					{
+						//Glyphs are sorted by x, only the visible part of a long line is sent to cairo
+						vint first = 0, last = run->glyphs.Count();
+						vint low = 0, high = last;
+						while(low < high)
+						{
+							vint mid = (low + high) / 2;
+							if(run->glyphs[mid].x < viewX1 - margin) low = mid + 1;
+							else high = mid;
+						}
+						first = low;
+
+						high = last;
+						while(low < high)
+						{
+							vint mid = (low + high) / 2;
+							if(run->glyphs[mid].x <= viewX2 + margin) low = mid + 1;
+							else high = mid;
+						}
+						last = low;
+
+						if(first < last)
+						{
+							cairo_show_glyphs(cairoContext, &run->glyphs[first], last - first);
+						}
+					}
+				}
+
+				cairo_restore(cairoContext);
+			}
+
+			void GuiColorizedTextElementRenderer::Render(Rect bounds)
+			{
+				if(!cairoContext || !glyphTable || !glyphTable->GetScaledFont()) return;
+
+				const GuiColorizedTextElement::ColorArray& colors = element->GetColors();
+				if(colors.Count() == 0) return;
+
+				TextLines& lines = element->GetLines();
+				wchar_t passwordChar = element->GetPasswordChar();
+				Point viewPosition = element->GetViewPosition();
+				Rect viewBounds(viewPosition, bounds.GetSize());
+				vint startRow = lines.GetTextPosFromPoint(Point(viewBounds.x1, viewBounds.y1)).row;
+				vint endRow = lines.GetTextPosFromPoint(Point(viewBounds.x2, viewBounds.y2)).row;
+				TextPos selectionBegin = element->GetCaretBegin() < element->GetCaretEnd() ? element->GetCaretBegin() : element->GetCaretEnd();
+				TextPos selectionEnd = element->GetCaretBegin() > element->GetCaretEnd() ? element->GetCaretBegin() : element->GetCaretEnd();
+				bool focused = element->GetFocused();
+				vint offsetX = bounds.x1 - viewPosition.x;
+
+				cairo_save(cairoContext);
+				cairo_rectangle(cairoContext, bounds.x1, bounds.y1, bounds.Width(), bounds.Height());
+				cairo_clip(cairoContext);
+				frame++;
+
+				for(vint row = startRow; row <= endRow; row++)
+				{
+					Rect startRect = lines.GetRectFromTextPos(TextPos(row, 0));
+					vint startColumn = lines.GetTextPosFromPoint(Point(viewBounds.x1, startRect.y1)).column;
+					vint endColumn = lines.GetTextPosFromPoint(Point(viewBounds.x2, startRect.y1)).column;
+					vint y = startRect.y1 - viewPosition.y + bounds.y1;
+					TextLine& line = lines.GetLine(row);
+
+					//Backgrounds of neighbouring characters with the same color are filled together
+					vint x = startColumn == 0 ? 0 : line.att[startColumn - 1].rightOffset;
+					vint fillX = x;
+					Color fillColor(0, 0, 0, 0);
+					vint selectionX1 = -1, selectionX2 = -1;
+
+					for(vint column = startColumn; column <= endColumn; column++)
+					{
+						bool inSelection = false;
+						if(selectionBegin.row == selectionEnd.row)
+						{
+							inSelection = (row == selectionBegin.row && selectionBegin.column <= column && column < selectionEnd.column);
+						}
+						else if(row == selectionBegin.row)
+						{
+							inSelection = selectionBegin.column <= column;
+						}
+						else if(row == selectionEnd.row)
+						{
+							inSelection = column < selectionEnd.column;
+						}
+						else
+						{
+							inSelection = selectionBegin.row < row && row < selectionEnd.row;
+						}
+
+						bool crlf = column == line.dataLength;
+						vint colorIndex = crlf ? 0 : line.att[column].colorIndex;
+						if(colorIndex >= colors.Count()) colorIndex = 0;
+
+						const ColorItem& item =
+							!inSelection ? colors[colorIndex].normal :
+							focused ? colors[colorIndex].selectedFocused :
+							colors[colorIndex].selectedUnfocused;
+						vint x2 = crlf ? x + startRect.Height() / 2 : line.att[column].rightOffset;
+
+						if(inSelection)
+						{
+							if(selectionX1 == -1) selectionX1 = x;
+							selectionX2 = x2;
+						}
+
+						if(item.background.value != fillColor.value)
+						{
+							if(fillColor.a > 0 && x > fillX)
+							{
+								cairo_rectangle(cairoContext, offsetX + fillX, y, x - fillX, startRect.Height());
+								helpers::SolidFill(cairoContext, fillColor);
+							}
+							fillColor = item.background;
+							fillX = x;
+						}
+						x = x2;
+					}
+
+					if(fillColor.a > 0 && x > fillX)
+					{
+						cairo_rectangle(cairoContext, offsetX + fillX, y, x - fillX, startRect.Height());
+						helpers::SolidFill(cairoContext, fillColor);
+					}
+
+					LineCache* cache = GetLineCache(line, passwordChar);
+					vint viewX1 = viewBounds.x1, viewX2 = viewBounds.x2;
+					if(selectionX1 == -1)
+					{
+						RenderLineText(cache, offsetX, y, viewX1, viewX2, false);
+					}
+					else
+					{
+						//Selected characters keep their cached glyphs and are only drawn again in the selection colors
+						cairo_save(cairoContext);
+						cairo_rectangle(cairoContext, bounds.x1, y, offsetX + selectionX1 - bounds.x1, startRect.Height());
+						cairo_rectangle(cairoContext, offsetX + selectionX2, y, bounds.x2 - offsetX - selectionX2, startRect.Height());
+						cairo_clip(cairoContext);
+						RenderLineText(cache, offsetX, y, viewX1, viewX2, false);
+						cairo_restore(cairoContext);
+
+						cairo_save(cairoContext);
+						cairo_rectangle(cairoContext, offsetX + selectionX1, y, selectionX2 - selectionX1, startRect.Height());
+						cairo_clip(cairoContext);
+						RenderLineText(cache, offsetX, y, viewX1, viewX2, true);
+						cairo_restore(cairoContext);
+					}
+				}
+
+				if(element->GetCaretVisible() && lines.IsAvailable(element->GetCaretEnd()))
+				{
+					Point caretPoint = lines.GetPointFromTextPos(element->GetCaretEnd());
+					vint height = lines.GetRowHeight();
+					cairo_rectangle(cairoContext, caretPoint.x - viewPosition.x + bounds.x1 - 1, caretPoint.y - viewPosition.y + bounds.y1 + 1, 2, height - 2);
+					helpers::SolidFill(cairoContext, element->GetCaretColor());
+				}
+
+				cairo_restore(cairoContext);
+				EvictLineCaches(endRow - startRow + 1);
+			}
+
+			void GuiColorizedTextElementRenderer::OnElementStateChanged()
+			{
+			}
+
+			void GuiColorizedTextElementRenderer::RenderTargetChangedInternal(IX11CairoRenderTarget* oldRT, IX11CairoRenderTarget* newRT)
+			{
+				//Pango layouts in the caches belong to the old context
+				lineCaches.Clear();
+				cairoContext = newRT ? newRT->GetCairoContext() : NULL;
+				element->GetLines().SetRenderTarget(newRT);
+			}
+		}
+	}
+}
@@ -0,0 +1,74 @@
+#ifndef __GAC_X11CAIRO_GUI_COLORIZED_TEXT_ELEMENT_RENDERER_H
+#define __GAC_X11CAIRO_GUI_COLORIZED_TEXT_ELEMENT_RENDERER_H
+
+#include <GacUI.h>
+#include "../X11CairoRenderTarget.h"
+#include "../X11CairoGlyphTable.h"
+
+namespace vl
+{
+	namespace presentation
+	{
+		namespace elements_x11cairo
+		{
+			using namespace elements;
+			class GuiColorizedTextElementRenderer: public Object, public IGuiGraphicsRenderer, protected GuiColorizedTextElement::ICallback
+			{
+				DEFINE_GUI_GRAPHICS_RENDERER(GuiColorizedTextElement, GuiColorizedTextElementRenderer, IX11CairoRenderTarget);
+
+			protected:
+				//Glyphs of a line are laid out once and reused until its text or colors change
+				struct GlyphRun
+				{
+					vint colorIndex;
+					collections::Array<cairo_glyph_t> glyphs;
+					PangoLayout* layout;
+					vint layoutX;
+					double layoutY;
+
+					GlyphRun();
+					~GlyphRun();
+				};
+
+				struct LineCache
+				{
+					collections::Array<wchar_t> text;
+					collections::Array<vuint32_t> colorIndices;
+					wchar_t passwordChar;
+					collections::List<Ptr<GlyphRun>> runs;
+					vint lastFrame;
+				};
+
+				typedef collections::Dictionary<vint, Ptr<LineCache>> LineCacheMap;
+
+				cairo_t* cairoContext;
+				PangoFontDescription* pangoFontDesc;
+				Ptr<X11CairoGlyphTable> glyphTable;
+				Ptr<text::CharMeasurer> charMeasurer;
+				LineCacheMap lineCaches;
+				vint frame;
+
+				void FontChanged();
+				void ColorChanged();
+
+				vint HashLine(text::TextLine& line, wchar_t passwordChar);
+				bool IsLineCacheValid(LineCache* cache, text::TextLine& line, wchar_t passwordChar);
+				Ptr<LineCache> BuildLineCache(text::TextLine& line, wchar_t passwordChar);
+				LineCache* GetLineCache(text::TextLine& line, wchar_t passwordChar);
+				void EvictLineCaches(vint visibleRows);
+				void RenderLineText(LineCache* cache, vint x, vint y, vint viewX1, vint viewX2, bool selected);
+
+			public:
+				GuiColorizedTextElementRenderer();
+
+				void InitializeInternal();
+				void FinalizeInternal();
+				void Render(Rect bounds);
+				void OnElementStateChanged();
+				void RenderTargetChangedInternal(IX11CairoRenderTarget* oldRT, IX11CairoRenderTarget* newRT);
+			};
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,70 @@
+#include "GuiFocusRectangleElementRenderer.h"
+#include "CairoHelpers.h"
+#include "../X11CairoResourceManager.h"
+
+namespace vl
+{
+	namespace presentation
+	{
+		namespace elements_x11cairo
+		{
+			GuiFocusRectangleElementRenderer::GuiFocusRectangleElementRenderer():
+				minSize(1, 1), cairoContext(NULL)
+			{
+			}
+
+			void GuiFocusRectangleElementRenderer::InitializeInternal()
+			{
+			}
+
+			void GuiFocusRectangleElementRenderer::FinalizeInternal()
+			{
+			}
+
+			void GuiFocusRectangleElementRenderer::Render(Rect bounds)
+			{
+				if(!cairoContext || bounds.Width() <= 0 || bounds.Height() <= 0) return;
+
+				cairo_save(cairoContext);
+				cairo_set_antialias(cairoContext, CAIRO_ANTIALIAS_NONE);
+
+				cairo_rectangle(cairoContext, bounds.x1, bounds.y1, bounds.Width(), 1);
+				if(bounds.Height() > 1)
+				{
+					cairo_rectangle(cairoContext, bounds.x1, bounds.y2 - 1, bounds.Width(), 1);
+				}
+				if(bounds.Height() > 2)
+				{
+					cairo_rectangle(cairoContext, bounds.x1, bounds.y1 + 1, 1, bounds.Height() - 2);
+					if(bounds.Width() > 1)
+					{
+						cairo_rectangle(cairoContext, bounds.x2 - 1, bounds.y1 + 1, 1, bounds.Height() - 2);
+					}
+				}
+
+				//Inverts every other pixel like DrawFocusRect, the pattern matrix maps user space to device space,
+				//so the checker stays anchored at the device origin under any translation
+				cairo_pattern_t* pattern = x11cairo::GetX11CairoResourceManager()->GetFocusRectanglePattern();
+				cairo_matrix_t matrix;
+				cairo_get_matrix(cairoContext, &matrix);
+				cairo_pattern_set_matrix(pattern, &matrix);
+				cairo_set_source(cairoContext, pattern);
+				cairo_set_operator(cairoContext, CAIRO_OPERATOR_DIFFERENCE);
+				cairo_fill(cairoContext);
+
+				cairo_restore(cairoContext);
+			}
+
+			void GuiFocusRectangleElementRenderer::OnElementStateChanged()
+			{
+			}
+
+			void GuiFocusRectangleElementRenderer::RenderTargetChangedInternal(IX11CairoRenderTarget* oldRT, IX11CairoRenderTarget* newRT)
+			{
+				if(newRT)
+					cairoContext = newRT->GetCairoContext();
+				else cairoContext = NULL;
+			}
+		}
+	}
+}
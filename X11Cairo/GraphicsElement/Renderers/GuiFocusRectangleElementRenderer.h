@@ -0,0 +1,34 @@
+#ifndef __GAC_X11CAIRO_GUI_FOCUS_RECTANGLE_ELEMENT_RENDERER_H
+#define __GAC_X11CAIRO_GUI_FOCUS_RECTANGLE_ELEMENT_RENDERER_H
+
+#include <GacUI.h>
+#include "../X11CairoRenderTarget.h"
+
+namespace vl
+{
+	namespace presentation
+	{
+		namespace elements_x11cairo
+		{
+			using namespace elements;
+			class GuiFocusRectangleElementRenderer: public Object, public IGuiGraphicsRenderer
+			{
+				DEFINE_GUI_GRAPHICS_RENDERER(GuiFocusRectangleElement, GuiFocusRectangleElementRenderer, IX11CairoRenderTarget);
+
+			protected:
+				cairo_t* cairoContext;
+
+			public:
+				GuiFocusRectangleElementRenderer();
+
+				void InitializeInternal();
+				void FinalizeInternal();
+				void Render(Rect bounds);
+				void OnElementStateChanged();
+				void RenderTargetChangedInternal(IX11CairoRenderTarget* oldRT, IX11CairoRenderTarget* newRT);
+			};
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,179 @@
+#include "GuiImageFrameElementRenderer.h"
+#include "CairoHelpers.h"
+
+using namespace vl::presentation::x11cairo;
+
+namespace vl
+{
+	namespace presentation
+	{
+		namespace elements_x11cairo
+		{
+			GuiImageFrameElementRenderer::GuiImageFrameElementRenderer()
+				: minSize(0, 0), cairoContext(NULL), frame(NULL)
+			{
+			}
+
+			void GuiImageFrameElementRenderer::InitializeInternal()
+			{
+				OnElementStateChanged();
+			}
+
+			void GuiImageFrameElementRenderer::FinalizeInternal()
+			{
+				if(frame)
+				{
+					frame->UninstallListener(this);
+					frame = NULL;
+				}
+			}
+
+			void GuiImageFrameElementRenderer::FrameDecoded(CairoImageFrame* decodedFrame)
+			{
+				//Only the area of this element is painted again
+				if(renderTarget && lastBounds.Width() > 0 && lastBounds.Height() > 0)
+				{
+					renderTarget->Invalidate(lastBounds);
+				}
+			}
+
+			void GuiImageFrameElementRenderer::Render(Rect bounds)
+			{
+				lastBounds = bounds;
+				if(!cairoContext || !frame) return;
+
+				Rect destination;
+				if(element->GetStretch())
+				{
+					destination = bounds;
+				}
+				else
+				{
+					vint x = 0, y = 0;
+					switch(element->GetHorizontalAlignment())
+					{
+					case Alignment::Left:
+						x = bounds.x1;
+						break;
+					case Alignment::Center:
+						x = bounds.x1 + (bounds.Width() - minSize.x) / 2;
+						break;
+					case Alignment::Right:
+						x = bounds.x2 - minSize.x;
+						break;
+					}
+
+					switch(element->GetVerticalAlignment())
+					{
+					case Alignment::Top:
+						y = bounds.y1;
+						break;
+					case Alignment::Center:
+						y = bounds.y1 + (bounds.Height() - minSize.y) / 2;
+						break;
+					case Alignment::Bottom:
+						y = bounds.y2 - minSize.y;
+						break;
+					}
+					destination = Rect(Point(x, y), minSize);
+				}
+
+				if(destination.Width() <= 0 || destination.Height() <= 0) return;
+
+				cairo_save(cairoContext);
+				cairo_rectangle(cairoContext, destination.x1, destination.y1, destination.Width(), destination.Height());
+
+				//Shrunk images use a box filtered copy made in the background,
+				//until it is ready cairo resamples the original
+				Size frameSize = frame->GetSize();
+				bool shrink = destination.Width() <= frameSize.x && destination.Height() <= frameSize.y && destination.GetSize() != frameSize;
+				Size surfaceSize = shrink ? destination.GetSize() : frameSize;
+
+				//Frames already copied to the display server are composited without sending any pixels
+				cairo_surface_t* surface = renderTarget->GetImageCache(frame, surfaceSize);
+				if(!surface)
+				{
+					//Decoding happens in the background, a placeholder is shown until FrameDecoded arrives
+					surface = frame->GetSurface();
+					if(!surface)
+					{
+						if(frame->IsDecoding())
+						{
+							helpers::SolidFill(cairoContext, Color(128, 128, 128, 48));
+						}
+						else
+						{
+							cairo_new_path(cairoContext);
+						}
+						cairo_restore(cairoContext);
+						return;
+					}
+
+					cairo_surface_t* scaled = shrink ? frame->GetScaledSurface(surfaceSize) : NULL;
+					if(scaled)
+					{
+						surface = scaled;
+					}
+					else
+					{
+						surfaceSize = Size(cairo_image_surface_get_width(surface), cairo_image_surface_get_height(surface));
+					}
+					renderTarget->UploadImage(frame, surface);
+				}
+
+				cairo_clip(cairoContext);
+				cairo_translate(cairoContext, destination.x1, destination.y1);
+				vint width = surfaceSize.x;
+				vint height = surfaceSize.y;
+
+				if(width != destination.Width() || height != destination.Height())
+				{
+					cairo_scale(cairoContext, (double)destination.Width() / width, (double)destination.Height() / height);
+				}
+
+				if(element->GetEnabled())
+				{
+					cairo_set_source_surface(cairoContext, surface, 0, 0);
+					cairo_paint(cairoContext);
+				}
+				else
+				{
+					//Disabled images are drawn without saturation
+					cairo_push_group(cairoContext);
+					cairo_set_source_surface(cairoContext, surface, 0, 0);
+					cairo_paint(cairoContext);
+					cairo_set_operator(cairoContext, CAIRO_OPERATOR_HSL_SATURATION);
+					cairo_set_source_rgb(cairoContext, 0.5, 0.5, 0.5);
+					cairo_mask_surface(cairoContext, surface, 0, 0);
+					cairo_pop_group_to_source(cairoContext);
+					cairo_paint(cairoContext);
+				}
+
+				cairo_restore(cairoContext);
+			}
+
+			void GuiImageFrameElementRenderer::OnElementStateChanged()
+			{
+				CairoImageFrame* newFrame = NULL;
+				if(element->GetImage())
+				{
+					newFrame = dynamic_cast<CairoImageFrame*>(element->GetImage()->GetFrame(element->GetFrameIndex()));
+				}
+
+				if(frame != newFrame)
+				{
+					if(frame) frame->UninstallListener(this);
+					frame = newFrame;
+					if(frame) frame->InstallListener(this);
+				}
+
+				minSize = frame ? frame->GetSize() : Size(0, 0);
+			}
+
+			void GuiImageFrameElementRenderer::RenderTargetChangedInternal(IX11CairoRenderTarget* oldRT, IX11CairoRenderTarget* newRT)
+			{
+				cairoContext = newRT ? newRT->GetCairoContext() : NULL;
+			}
+		}
+	}
+}
@@ -0,0 +1,39 @@
+#ifndef __GAC_X11CAIRO_GUI_IMAGE_FRAME_ELEMENT_RENDERER_H
+#define __GAC_X11CAIRO_GUI_IMAGE_FRAME_ELEMENT_RENDERER_H
+
+#include <GacUI.h>
+#include "../X11CairoRenderTarget.h"
+#include "../../NativeWindow/Common/ServicesImpl/CairoImageService.h"
+
+namespace vl
+{
+	namespace presentation
+	{
+		namespace elements_x11cairo
+		{
+			using namespace elements;
+			class GuiImageFrameElementRenderer: public Object, public IGuiGraphicsRenderer, protected x11cairo::ICairoImageFrameListener
+			{
+				DEFINE_GUI_GRAPHICS_RENDERER(GuiImageFrameElement, GuiImageFrameElementRenderer, IX11CairoRenderTarget);
+
+			protected:
+				cairo_t* cairoContext;
+				x11cairo::CairoImageFrame* frame;
+				Rect lastBounds;
+
+				void FrameDecoded(x11cairo::CairoImageFrame* decodedFrame)override;
+
+			public:
+				GuiImageFrameElementRenderer();
+
+				void InitializeInternal();
+				void FinalizeInternal();
+				void Render(Rect bounds);
+				void OnElementStateChanged();
+				void RenderTargetChangedInternal(IX11CairoRenderTarget* oldRT, IX11CairoRenderTarget* newRT);
+			};
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,89 @@
+#include "GuiRoundBorderElementRenderer.h"
+#include "CairoHelpers.h"
+#include "../X11CairoResourceManager.h"
+
+namespace vl
+{
+	namespace presentation
+	{
+		namespace elements_x11cairo
+		{
+			GuiRoundBorderElementRenderer::GuiRoundBorderElementRenderer():
+				minSize(1, 1), cairoContext(NULL)
+			{
+			}
+
+			void GuiRoundBorderElementRenderer::DrawCorner(cairo_surface_t* corners, vint radius, vint sourceX, vint sourceY, vint x, vint y)
+			{
+				cairo_set_source_surface(cairoContext, corners, x - sourceX, y - sourceY);
+				cairo_rectangle(cairoContext, x, y, radius, radius);
+				cairo_fill(cairoContext);
+			}
+
+			void GuiRoundBorderElementRenderer::InitializeInternal()
+			{
+			}
+
+			void GuiRoundBorderElementRenderer::FinalizeInternal()
+			{
+			}
+
+			void GuiRoundBorderElementRenderer::Render(Rect bounds)
+			{
+				Color color = element->GetColor();
+				if(!cairoContext || color.a == 0 || bounds.Width() <= 0 || bounds.Height() <= 0) return;
+
+				vint radius = element->GetRadius();
+				if(radius > bounds.Width() / 2) radius = bounds.Width() / 2;
+				if(radius > bounds.Height() / 2) radius = bounds.Height() / 2;
+				if(radius < 0) radius = 0;
+
+				cairo_save(cairoContext);
+
+				//Only the corners are antialiased, they come from a surface rasterized once for each radius and color
+				if(radius > 0)
+				{
+					cairo_surface_t* corners = x11cairo::GetX11CairoResourceManager()->GetRoundBorderCorners(radius, color);
+					DrawCorner(corners, radius, 0, 0, bounds.x1, bounds.y1);
+					DrawCorner(corners, radius, radius, 0, bounds.x2 - radius, bounds.y1);
+					DrawCorner(corners, radius, 0, radius, bounds.x1, bounds.y2 - radius);
+					DrawCorner(corners, radius, radius, radius, bounds.x2 - radius, bounds.y2 - radius);
+				}
+
+				//Straight edges are whole pixels and go to the pixel aligned fill path of cairo
+				vint width = bounds.Width() - radius * 2;
+				vint height = bounds.Height() - radius * 2;
+				if(width > 0)
+				{
+					cairo_rectangle(cairoContext, bounds.x1 + radius, bounds.y1, width, 1);
+					if(bounds.Height() > 1)
+					{
+						cairo_rectangle(cairoContext, bounds.x1 + radius, bounds.y2 - 1, width, 1);
+					}
+				}
+				if(height > 0)
+				{
+					cairo_rectangle(cairoContext, bounds.x1, bounds.y1 + radius, 1, height);
+					if(bounds.Width() > 1)
+					{
+						cairo_rectangle(cairoContext, bounds.x2 - 1, bounds.y1 + radius, 1, height);
+					}
+				}
+				helpers::SolidFill(cairoContext, color);
+
+				cairo_restore(cairoContext);
+			}
+
+			void GuiRoundBorderElementRenderer::OnElementStateChanged()
+			{
+			}
+
+			void GuiRoundBorderElementRenderer::RenderTargetChangedInternal(IX11CairoRenderTarget* oldRT, IX11CairoRenderTarget* newRT)
+			{
+				if(newRT)
+					cairoContext = newRT->GetCairoContext();
+				else cairoContext = NULL;
+			}
+		}
+	}
+}
@@ -0,0 +1,36 @@
+#ifndef __GAC_X11CAIRO_GUI_ROUND_BORDER_ELEMENT_RENDERER_H
+#define __GAC_X11CAIRO_GUI_ROUND_BORDER_ELEMENT_RENDERER_H
+
+#include <GacUI.h>
+#include "../X11CairoRenderTarget.h"
+
+namespace vl
+{
+	namespace presentation
+	{
+		namespace elements_x11cairo
+		{
+			using namespace elements;
+			class GuiRoundBorderElementRenderer: public Object, public IGuiGraphicsRenderer
+			{
+				DEFINE_GUI_GRAPHICS_RENDERER(GuiRoundBorderElement, GuiRoundBorderElementRenderer, IX11CairoRenderTarget);
+
+			protected:
+				cairo_t* cairoContext;
+
+				void DrawCorner(cairo_surface_t* corners, vint radius, vint sourceX, vint sourceY, vint x, vint y);
+
+			public:
+				GuiRoundBorderElementRenderer();
+
+				void InitializeInternal();
+				void FinalizeInternal();
+				void Render(Rect bounds);
+				void OnElementStateChanged();
+				void RenderTargetChangedInternal(IX11CairoRenderTarget* oldRT, IX11CairoRenderTarget* newRT);
+			};
+		}
+	}
+}
+
+#endif
@@ -1,5 +1,6 @@
 #include "GuiSolidLabelElementRenderer.h"
 #include "CairoHelpers.h"
+#include "../X11CairoResourceManager.h"
 
 using namespace vl::collections;
 using namespace vl::presentation::elements::text;
@@ -10,7 +11,7 @@ namespace vl
 		namespace elements_x11cairo
 		{
 			GuiSolidLabelElementRenderer::GuiSolidLabelElementRenderer()
-				: minSize(1, 1), cairoContext(NULL), pangoFontDesc(NULL), attrList(NULL), layout(NULL)
+				: minSize(1, 1), cairoContext(NULL), pangoFontDesc(NULL), attrList(NULL), layout(NULL), simpleText(false)
 			{
 			}
 
@@ -32,6 +33,8 @@ namespace vl
 
 				if(attrList)
 					pango_attr_list_unref(attrList);
+
+				glyphTable = NULL;
 			}
 
 			void GuiSolidLabelElementRenderer::Render(Rect bounds)
@@ -49,12 +52,21 @@ namespace vl
 							1.0 * color.a / 255
 							);
 
-					if(element->GetWrapLine()) pango_layout_set_width(layout, bounds.Width() * PANGO_SCALE);
-					pango_cairo_update_layout(cairoContext, layout);
 					int layoutWidth, layoutHeight;
 					int plotX1, plotY1;
 
-					pango_layout_get_pixel_size( layout, &layoutWidth, &layoutHeight);
+					if(simpleText)
+					{
+						layoutWidth = minSize.x;
+						layoutHeight = minSize.y;
+					}
+					else
+					{
+						if(element->GetWrapLine()) pango_layout_set_width(layout, bounds.Width() * PANGO_SCALE);
+						pango_cairo_update_layout(cairoContext, layout);
+						pango_layout_get_pixel_size( layout, &layoutWidth, &layoutHeight);
+					}
+
 					switch(element->GetHorizontalAlignment())
 					{
 					case Alignment::Left:
@@ -81,17 +93,59 @@ namespace vl
 						break;
 					}
 
-					cairo_move_to(cairoContext, plotX1, plotY1);
+					if(simpleText)
+					{
+						cairo_translate(cairoContext, plotX1, plotY1);
+						cairo_set_scaled_font(cairoContext, glyphTable->GetScaledFont());
+						cairo_show_glyphs(cairoContext, &glyphs[0], glyphs.Count());
+					}
+					else
+					{
+						cairo_move_to(cairoContext, plotX1, plotY1);
 
-					pango_cairo_layout_path(cairoContext, layout);
-					cairo_fill(cairoContext);
+						pango_cairo_layout_path(cairoContext, layout);
+						cairo_fill(cairoContext);
+					}
 
 					cairo_restore(cairoContext);
 				}
 			}
 
+			bool GuiSolidLabelElementRenderer::UpdateSimpleText()
+			{
+				//Short single line labels without decorations skip Pango shaping entirely
+				FontProperties font = element->GetFont();
+				if(element->GetWrapLine() || font.underline || font.strikeline || font.fontFamily == L"Webdings")
+				{
+					return false;
+				}
+
+				glyphTable = x11cairo::GetX11CairoResourceManager()->GetGlyphTable(cairoContext, font);
+				WString text = element->GetText();
+				if(!glyphTable->IsSimpleText(text))
+				{
+					return false;
+				}
+
+				glyphTable->LayoutGlyphs(text, glyphs);
+				minSize.x = glyphTable->MeasureWidth(text);
+				minSize.y = glyphTable->GetHeight();
+				return true;
+			}
+
 			void GuiSolidLabelElementRenderer::OnElementStateChanged()
 			{
+				simpleText = cairoContext && UpdateSimpleText();
+				if(simpleText)
+				{
+					if(layout)
+					{
+						g_object_unref(layout);
+						layout = NULL;
+					}
+					return;
+				}
+
 				FontProperties font = element->GetFont();
 				Color color = element->GetColor();
 				int layoutWidth, layoutHeight;
@@ -132,7 +186,7 @@ namespace vl
 
 				if(cairoContext)
 				{
-					layout = pango_cairo_create_layout(cairoContext);
+					layout = helpers::CreatePangoLayout(cairoContext);
 
 					WString wtext = (font.fontFamily == L"Webdings") ? helpers::WebdingsMap(element->GetText()) : element->GetText();
 					AString text = wtoa(wtext);
@@ -1,8 +1,9 @@
-#ifndef __GAC_X11CAIRO_GUI_COLORIZED_TEXT_ELEMENT_RENDERER_H
-#define __GAC_X11CAIRO_GUI_COLORIZED_TEXT_ELEMENT_RENDERER_H
+#ifndef __GAC_X11CAIRO_GUI_SOLID_LABEL_ELEMENT_RENDERER_H
+#define __GAC_X11CAIRO_GUI_SOLID_LABEL_ELEMENT_RENDERER_H
 
 #include <GacUI.h>
 #include "../X11CairoRenderTarget.h"
+#include "../X11CairoGlyphTable.h"
 
 namespace vl
 {
@@ -20,6 +21,11 @@ namespace vl
 				PangoFontDescription* pangoFontDesc;
 				PangoAttrList* attrList;
 				PangoLayout *layout;
+				Ptr<X11CairoGlyphTable> glyphTable;
+				collections::Array<cairo_glyph_t> glyphs;
+				bool simpleText;
+
+				bool UpdateSimpleText();
 
 			public:
 				GuiSolidLabelElementRenderer();
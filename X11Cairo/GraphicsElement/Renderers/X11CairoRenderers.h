@@ -4,7 +4,13 @@
 #include "GuiSolidBackgroundElementRenderer.h"
 #include "GuiSolidLabelElementRenderer.h"
 #include "GuiSolidBorderElementRenderer.h"
+#include "GuiRoundBorderElementRenderer.h"
+#include "Gui3DBorderElementRenderer.h"
+#include "Gui3DSplitterElementRenderer.h"
+#include "GuiFocusRectangleElementRenderer.h"
 #include "GuiGradientBackgroundElementRenderer.h"
 #include "GuiPolygonElementRenderer.h"
+#include "GuiColorizedTextElementRenderer.h"
+#include "GuiImageFrameElementRenderer.h"
 
 #endif
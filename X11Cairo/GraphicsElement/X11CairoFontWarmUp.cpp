@@ -0,0 +1,230 @@
+#include <limits.h>
+
+#include <fontconfig/fontconfig.h>
+
+#include "X11CairoFontWarmUp.h"
+#include "Renderers/CairoHelpers.h"
+
+using namespace vl::collections;
+
+namespace vl
+{
+	namespace presentation
+	{
+		namespace elements_x11cairo
+		{
+			//The warm-up thread loads fonts into a font map of its own. Pango font maps are not thread safe,
+			//so the main thread takes the map over on its first use of Pango instead of sharing it, and keeps
+			//the fontsets and glyphs loaded so far. Fonts queued after that only warm fontconfig, which is thread safe.
+			class X11CairoFontWarmUp: public Object
+			{
+			protected:
+				List<FontProperties> pendingFonts;
+				List<FontProperties> loadedFonts;
+				SpinLock lock;
+				Semaphore semaphore;
+				Thread* thread;
+				volatile bool stopping;
+
+				//Only used by the thread holding fontMapSection, the main thread holds it for at most one font
+				CriticalSection fontMapSection;
+				PangoFontMap* fontMap;
+				PangoLayout* fontMapLayout;
+				bool fontMapTaken;
+
+				void WarmUpFontMap(const FontProperties& font)
+				{
+					if(!fontMapLayout)
+					{
+						PangoContext* context = pango_font_map_create_context(fontMap);
+						fontMapLayout = pango_layout_new(context);
+						g_object_unref(context);
+						pango_layout_set_text(fontMapLayout, "The quick brown fox jumps over the lazy dog. 0123456789 \xC3\x80\xC3\xA9\xC3\xB1\xC3\xBC", -1);
+					}
+
+					PangoFontDescription* desc = helpers::CreateFontDescription(font);
+					pango_layout_set_font_description(fontMapLayout, desc);
+
+					int width, height;
+					pango_layout_get_pixel_size(fontMapLayout, &width, &height);
+					pango_font_description_free(desc);
+				}
+
+				void WarmUpFontconfig(const FontProperties& font)
+				{
+					//The same family, size, weight and slant Pango asks fontconfig for when it builds the fontset
+					AString family = wtoa(font.fontFamily);
+					FcPattern* pattern = FcPatternCreate();
+					FcPatternAddString(pattern, FC_FAMILY, (const FcChar8*)family.Buffer());
+					FcPatternAddDouble(pattern, FC_PIXEL_SIZE, (double)font.size);
+					FcPatternAddInteger(pattern, FC_WEIGHT, font.bold ? FC_WEIGHT_BOLD : FC_WEIGHT_MEDIUM);
+					FcPatternAddInteger(pattern, FC_SLANT, font.italic ? FC_SLANT_ITALIC : FC_SLANT_ROMAN);
+					FcConfigSubstitute(NULL, pattern, FcMatchPattern);
+					FcDefaultSubstitute(pattern);
+
+					FcResult result;
+					FcFontSet* fonts = FcFontSort(NULL, pattern, FcTrue, NULL, &result);
+					if(fonts)
+					{
+						FcFontSetDestroy(fonts);
+					}
+					FcPatternDestroy(pattern);
+				}
+
+				void Run()
+				{
+					while(!stopping)
+					{
+						semaphore.Wait();
+
+						FontProperties font;
+						bool found = false;
+						SPIN_LOCK(lock)
+						{
+							if(!stopping && pendingFonts.Count() > 0)
+							{
+								font = pendingFonts[0];
+								pendingFonts.RemoveAt(0);
+								found = true;
+							}
+						}
+
+						if(found)
+						{
+							bool taken = true;
+							fontMapSection.Enter();
+							if(!fontMapTaken)
+							{
+								taken = false;
+								WarmUpFontMap(font);
+							}
+							fontMapSection.Leave();
+
+							if(taken)
+							{
+								WarmUpFontconfig(font);
+							}
+						}
+					}
+				}
+
+			public:
+				X11CairoFontWarmUp():
+					thread(NULL),
+					stopping(false),
+					fontMap(NULL),
+					fontMapLayout(NULL),
+					fontMapTaken(false)
+				{
+					semaphore.Create(0, INT_MAX);
+				}
+
+				~X11CairoFontWarmUp()
+				{
+					Stop();
+					if(fontMapLayout) g_object_unref(fontMapLayout);
+					if(fontMap) g_object_unref(fontMap);
+				}
+
+				void Start()
+				{
+					fontMap = pango_cairo_font_map_new();
+					thread = Thread::CreateAndStart([this](){ Run(); }, false);
+				}
+
+				void Stop()
+				{
+					if(thread)
+					{
+						stopping = true;
+						semaphore.Release();
+						thread->Wait();
+						delete thread;
+						thread = NULL;
+					}
+				}
+
+				void Queue(const FontProperties& font)
+				{
+					SPIN_LOCK(lock)
+					{
+						if(loadedFonts.Contains(font))
+						{
+							return;
+						}
+						loadedFonts.Add(font);
+						pendingFonts.Add(font);
+					}
+					semaphore.Release();
+				}
+
+				//Waits for the font being loaded on the warm-up thread, the caller owns the returned reference
+				PangoFontMap* TakeFontMap()
+				{
+					PangoFontMap* map = NULL;
+					fontMapSection.Enter();
+					if(!fontMapTaken)
+					{
+						fontMapTaken = true;
+						if(fontMapLayout)
+						{
+							g_object_unref(fontMapLayout);
+							fontMapLayout = NULL;
+						}
+						map = fontMap;
+						fontMap = NULL;
+					}
+					fontMapSection.Leave();
+					return map;
+				}
+			};
+
+			X11CairoFontWarmUp* fontWarmUp = NULL;
+			bool fontMapAdopted = false;
+
+			void StartX11CairoFontWarmUp()
+			{
+				if(!fontWarmUp)
+				{
+					fontWarmUp = new X11CairoFontWarmUp();
+					fontWarmUp->Start();
+					fontWarmUp->Queue(GetCurrentController()->ResourceService()->GetDefaultFont());
+				}
+			}
+
+			void StopX11CairoFontWarmUp()
+			{
+				if(fontWarmUp)
+				{
+					delete fontWarmUp;
+					fontWarmUp = NULL;
+				}
+			}
+
+			PangoFontMap* GetX11CairoFontMap()
+			{
+				if(!fontMapAdopted)
+				{
+					fontMapAdopted = true;
+					if(fontWarmUp)
+					{
+						if(PangoFontMap* map = fontWarmUp->TakeFontMap())
+						{
+							pango_cairo_font_map_set_default(PANGO_CAIRO_FONT_MAP(map));
+							g_object_unref(map);
+						}
+					}
+				}
+				return pango_cairo_font_map_get_default();
+			}
+
+			void WarmUpX11CairoFont(const FontProperties& font)
+			{
+				if(fontWarmUp)
+				{
+					fontWarmUp->Queue(font);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,25 @@
+#ifndef __GAC_X11CAIRO_X11_CAIRO_FONT_WARM_UP_H
+#define __GAC_X11CAIRO_X11_CAIRO_FONT_WARM_UP_H
+
+#include <GacUI.h>
+#include "CairoPangoIncludes.h"
+
+namespace vl
+{
+	namespace presentation
+	{
+		namespace elements_x11cairo
+		{
+			extern void StartX11CairoFontWarmUp();
+			extern void StopX11CairoFontWarmUp();
+
+			//Queue a font to be loaded and shaped on the warm-up thread
+			extern void WarmUpX11CairoFont(const FontProperties& font);
+			//The font map of the main thread. The first call makes the font map of the warm-up thread,
+			//with everything it loaded so far, the default font map of the calling thread
+			extern PangoFontMap* GetX11CairoFontMap();
+		}
+	}
+}
+
+#endif
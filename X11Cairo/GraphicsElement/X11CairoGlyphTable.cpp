@@ -0,0 +1,217 @@
+#include <string.h>
+#include <wchar.h>
+
+#include "X11CairoGlyphTable.h"
+#include "Renderers/CairoHelpers.h"
+
+using namespace vl::collections;
+
+namespace vl
+{
+	namespace presentation
+	{
+		namespace elements_x11cairo
+		{
+			X11CairoGlyphTable::X11CairoGlyphTable(cairo_t* context, const FontProperties& font):
+				pangoFont(NULL),
+				scaledFont(NULL),
+				ascent(0),
+				height(0)
+			{
+				memset(glyphs, 0, sizeof(glyphs));
+				memset(advances, 0, sizeof(advances));
+				memset(simple, 0, sizeof(simple));
+
+				PangoContext* pangoContext = helpers::CreatePangoContext(context);
+				PangoFontDescription* desc = helpers::CreateFontDescription(font);
+				PangoLayout* layout = pango_layout_new(pangoContext);
+				pango_layout_set_font_description(layout, desc);
+
+				pango_layout_set_text(layout, "0", 1);
+				PangoLayoutLine* digitLine = pango_layout_get_line_readonly(layout, 0);
+				if(digitLine && digitLine->runs)
+				{
+					pangoFont = (PangoFont*)g_object_ref(((PangoGlyphItem*)digitLine->runs->data)->item->analysis.font);
+				}
+
+				if(pangoFont)
+				{
+					scaledFont = cairo_scaled_font_reference(pango_cairo_font_get_scaled_font(PANGO_CAIRO_FONT(pangoFont)));
+
+					int layoutWidth, layoutHeight;
+					pango_layout_get_pixel_size(layout, &layoutWidth, &layoutHeight);
+					ascent = pango_layout_get_baseline(layout);
+					height = layoutHeight;
+
+					List<vint> asciiChars, numericChars;
+					for(vint i = 0x20; i < TableSize; i++)
+					{
+						if(i >= 0x7F && i < 0xA0) continue;
+
+						wchar_t c = (wchar_t)i;
+						AString text = helpers::WStringToUtf8(&c, 1);
+						pango_layout_set_text(layout, text.Buffer(), text.Length());
+
+						//Only keep characters that Pango shapes into a single glyph of this font,
+						//everything else needs fallback fonts and goes through Pango
+						PangoLayoutLine* line = pango_layout_get_line_readonly(layout, 0);
+						if(!line || !line->runs || line->runs->next) continue;
+
+						PangoGlyphItem* run = (PangoGlyphItem*)line->runs->data;
+						if(run->item->analysis.font != pangoFont || run->glyphs->num_glyphs != 1) continue;
+
+						PangoGlyphInfo& info = run->glyphs->glyphs[0];
+						if((info.glyph & PANGO_GLYPH_UNKNOWN_FLAG) || info.glyph == PANGO_GLYPH_EMPTY) continue;
+						if(info.geometry.x_offset != 0 || info.geometry.y_offset != 0) continue;
+
+						glyphs[i] = info.glyph;
+						advances[i] = info.geometry.width;
+
+						if(i < 0x7F)
+						{
+							asciiChars.Add(i);
+							if((i >= L'0' && i <= L'9') || wcschr(L" .,:;+-*/=%$#()", c))
+							{
+								numericChars.Add(i);
+							}
+						}
+					}
+
+					//Per character advances ignore kerning and ligatures,
+					//so only accept a character set whose pairs are shaped without them
+					List<vint>* simpleChars = NULL;
+					if(CheckPairs(layout, asciiChars))
+					{
+						simpleChars = &asciiChars;
+					}
+					else if(CheckPairs(layout, numericChars))
+					{
+						simpleChars = &numericChars;
+					}
+
+					if(simpleChars)
+					{
+						FOREACH(vint, i, *simpleChars)
+						{
+							simple[i] = true;
+						}
+					}
+				}
+
+				g_object_unref(layout);
+				pango_font_description_free(desc);
+				g_object_unref(pangoContext);
+			}
+
+			X11CairoGlyphTable::~X11CairoGlyphTable()
+			{
+				if(scaledFont) cairo_scaled_font_destroy(scaledFont);
+				if(pangoFont) g_object_unref(pangoFont);
+			}
+
+			bool X11CairoGlyphTable::CheckPairs(PangoLayout* layout, const List<vint>& chars)
+			{
+				if(chars.Count() == 0) return false;
+
+				//Each character, then the character paired with every later one, then a closing first character:
+				//"a ab ac b bc c a". The n*n+1 characters form n*n neighbouring pairs, one for each ordered pair
+				Array<wchar_t> sequence(chars.Count() * chars.Count() + 1);
+				vint length = 0;
+				int expectedWidth = 0;
+				for(vint i = 0; i < chars.Count(); i++)
+				{
+					sequence[length++] = (wchar_t)chars[i];
+					for(vint j = i + 1; j < chars.Count(); j++)
+					{
+						sequence[length++] = (wchar_t)chars[i];
+						sequence[length++] = (wchar_t)chars[j];
+					}
+				}
+				sequence[length++] = (wchar_t)chars[0];
+
+				for(vint i = 0; i < length; i++)
+				{
+					expectedWidth += advances[sequence[i]];
+				}
+
+				AString text = helpers::WStringToUtf8(&sequence[0], length);
+				pango_layout_set_text(layout, text.Buffer(), text.Length());
+
+				PangoLayoutLine* line = pango_layout_get_line_readonly(layout, 0);
+				if(!line || pango_layout_get_line_count(layout) != 1) return false;
+
+				vint glyphCount = 0;
+				for(GSList* runs = line->runs; runs; runs = runs->next)
+				{
+					glyphCount += ((PangoGlyphItem*)runs->data)->glyphs->num_glyphs;
+				}
+
+				PangoRectangle logical;
+				pango_layout_line_get_extents(line, NULL, &logical);
+				return glyphCount == length && logical.width == expectedWidth;
+			}
+
+			cairo_scaled_font_t* X11CairoGlyphTable::GetScaledFont()
+			{
+				return scaledFont;
+			}
+
+			vint X11CairoGlyphTable::GetHeight()
+			{
+				return height;
+			}
+
+			double X11CairoGlyphTable::GetBaseline()
+			{
+				return (double)ascent / PANGO_SCALE;
+			}
+
+			bool X11CairoGlyphTable::GetGlyph(vint c, unsigned long& glyph)
+			{
+				if(c < 0 || c >= TableSize || glyphs[c] == 0) return false;
+				glyph = glyphs[c];
+				return true;
+			}
+
+			bool X11CairoGlyphTable::IsSimpleText(const WString& text)
+			{
+				if(!scaledFont || text.Length() == 0) return false;
+
+				const wchar_t* buffer = text.Buffer();
+				for(vint i = 0; i < text.Length(); i++)
+				{
+					vuint32_t c = (vuint32_t)buffer[i];
+					if(c >= TableSize || !simple[c]) return false;
+				}
+				return true;
+			}
+
+			vint X11CairoGlyphTable::MeasureWidth(const WString& text)
+			{
+				const wchar_t* buffer = text.Buffer();
+				int width = 0;
+				for(vint i = 0; i < text.Length(); i++)
+				{
+					width += advances[buffer[i]];
+				}
+				return (width + PANGO_SCALE - 1) / PANGO_SCALE;
+			}
+
+			void X11CairoGlyphTable::LayoutGlyphs(const WString& text, Array<cairo_glyph_t>& result)
+			{
+				const wchar_t* buffer = text.Buffer();
+				double baseline = (double)ascent / PANGO_SCALE;
+				int x = 0;
+
+				result.Resize(text.Length());
+				for(vint i = 0; i < text.Length(); i++)
+				{
+					result[i].index = glyphs[buffer[i]];
+					result[i].x = (double)x / PANGO_SCALE;
+					result[i].y = baseline;
+					x += advances[buffer[i]];
+				}
+			}
+		}
+	}
+}
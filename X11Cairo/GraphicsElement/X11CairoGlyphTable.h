@@ -0,0 +1,48 @@
+#ifndef __GAC_X11CAIRO_X11_CAIRO_GLYPH_TABLE_H
+#define __GAC_X11CAIRO_X11_CAIRO_GLYPH_TABLE_H
+
+#include <GacUI.h>
+#include "CairoPangoIncludes.h"
+
+namespace vl
+{
+	namespace presentation
+	{
+		namespace elements_x11cairo
+		{
+			//Glyph indices and advances of the Latin-1 range for one font, so that
+			//simple single line text can be drawn with cairo_show_glyphs directly
+			class X11CairoGlyphTable: public Object
+			{
+			public:
+				static const vint TableSize = 256;
+
+			protected:
+				PangoFont* pangoFont;
+				cairo_scaled_font_t* scaledFont;
+				unsigned long glyphs[TableSize];
+				int advances[TableSize];
+				bool simple[TableSize];
+				int ascent;
+				vint height;
+
+				bool CheckPairs(PangoLayout* layout, const collections::List<vint>& chars);
+
+			public:
+				X11CairoGlyphTable(cairo_t* context, const FontProperties& font);
+				~X11CairoGlyphTable();
+
+				cairo_scaled_font_t* GetScaledFont();
+				vint GetHeight();
+				double GetBaseline();
+				bool GetGlyph(vint c, unsigned long& glyph);
+
+				bool IsSimpleText(const WString& text);
+				vint MeasureWidth(const WString& text);
+				void LayoutGlyphs(const WString& text, collections::Array<cairo_glyph_t>& result);
+			};
+		}
+	}
+}
+
+#endif
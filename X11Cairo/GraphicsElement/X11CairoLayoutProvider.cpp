@@ -0,0 +1,794 @@
+#include "X11CairoLayoutProvider.h"
+#include "X11CairoRenderTarget.h"
+#include "Renderers/CairoHelpers.h"
+
+using namespace vl::collections;
+
+namespace vl
+{
+	namespace presentation
+	{
+		namespace elements_x11cairo
+		{
+			class X11CairoParagraph: public Object, public IGuiGraphicsParagraph
+			{
+			protected:
+				struct InlineObject
+				{
+					vint							start;
+					vint							length;
+					InlineObjectProperties			properties;
+				};
+
+				struct LineMetrics
+				{
+					vint							start;
+					vint							end;
+					vint							y1;
+					vint							y2;
+					vint							caretOffset;
+				};
+
+				X11CairoLayoutProvider*				provider;
+				IX11CairoRenderTarget*				renderTarget;
+				WString								paragraphText;
+				AString								utf8Text;
+				Array<vint>							charToByte;
+
+				PangoLayout*						layout;
+				PangoAttrList*						attrList;
+				List<InlineObject>					inlineObjects;
+				bool								wrapLine;
+				vint								maxWidth;
+				Alignment							paragraphAlignment;
+
+				vint								caret;
+				Color								caretColor;
+				bool								caretFrontSide;
+
+				//Formatting only marks the layout dirty, the layout and the metrics below
+				//are rebuilt once before the next query or render
+				bool								attributesDirty;
+				bool								geometryDirty;
+				Array<LineMetrics>					lines;
+				Array<vint>							lineCaretX;
+				Array<bool>							caretStops;
+				vint								layoutHeight;
+
+				//Text and backgrounds are rasterized once and reused until the paragraph is edited,
+				//inline objects and the caret are drawn on top of it
+				cairo_surface_t*					rasterCache;
+				Rect								rasterBounds;
+
+				bool CheckRange(vint start, vint length)
+				{
+					return start >= 0 && length >= 0 && start + length <= paragraphText.Length();
+				}
+
+				void ChangeAttribute(vint start, vint length, PangoAttribute* attribute)
+				{
+					attribute->start_index = charToByte[start];
+					attribute->end_index = charToByte[start + length];
+					pango_attr_list_change(attrList, attribute);
+				}
+
+				vint ByteToChar(vint byteIndex)
+				{
+					vint start = 0;
+					vint end = charToByte.Count() - 1;
+					while(start < end)
+					{
+						vint middle = (start + end + 1) / 2;
+						if(charToByte[middle] <= byteIndex)
+						{
+							start = middle;
+						}
+						else
+						{
+							end = middle - 1;
+						}
+					}
+					return start;
+				}
+
+				void ApplyAttributes()
+				{
+					//Inline objects become shape attributes only when the layout is built
+					PangoAttrList* attributes = pango_attr_list_copy(attrList);
+					FOREACH(InlineObject, inlineObject, inlineObjects)
+					{
+						Size size = inlineObject.properties.size;
+						vint baseline = inlineObject.properties.baseline == -1 ? size.y : inlineObject.properties.baseline;
+
+						PangoRectangle rect;
+						rect.x = 0;
+						rect.y = -baseline * PANGO_SCALE;
+						rect.width = size.x * PANGO_SCALE;
+						rect.height = size.y * PANGO_SCALE;
+
+						PangoAttribute* shape = pango_attr_shape_new(&rect, &rect);
+						shape->start_index = charToByte[inlineObject.start];
+						shape->end_index = charToByte[inlineObject.start + 1];
+						pango_attr_list_change(attributes, shape);
+
+						if(inlineObject.length > 1)
+						{
+							PangoRectangle empty = { 0, 0, 0, 0 };
+							PangoAttribute* rest = pango_attr_shape_new(&empty, &empty);
+							rest->start_index = charToByte[inlineObject.start + 1];
+							rest->end_index = charToByte[inlineObject.start + inlineObject.length];
+							pango_attr_list_change(attributes, rest);
+						}
+					}
+
+					pango_layout_set_attributes(layout, attributes);
+					pango_attr_list_unref(attributes);
+				}
+
+				void BuildMetrics()
+				{
+					vint length = paragraphText.Length();
+
+					gint logAttrCount = 0;
+					const PangoLogAttr* logAttrs = pango_layout_get_log_attrs_readonly(layout, &logAttrCount);
+					caretStops.Resize(length + 1);
+					for(vint i = 0; i <= length; i++)
+					{
+						caretStops[i] = i < logAttrCount ? logAttrs[i].is_cursor_position : false;
+					}
+					caretStops[0] = true;
+					caretStops[length] = true;
+
+					lines.Resize(pango_layout_get_line_count(layout));
+					lineCaretX.Resize(length + lines.Count());
+
+					vint lineIndex = 0;
+					vint caretOffset = 0;
+					PangoLayoutIter* iter = pango_layout_get_iter(layout);
+					do
+					{
+						PangoLayoutLine* line = pango_layout_iter_get_line_readonly(iter);
+						int y1, y2;
+						pango_layout_iter_get_line_yrange(iter, &y1, &y2);
+						PangoRectangle logical;
+						pango_layout_iter_get_line_extents(iter, NULL, &logical);
+
+						LineMetrics& metrics = lines[lineIndex++];
+						metrics.start = ByteToChar(line->start_index);
+						metrics.end = ByteToChar(line->start_index + line->length);
+						metrics.y1 = PANGO_PIXELS_FLOOR(y1);
+						metrics.y2 = PANGO_PIXELS_CEIL(y2);
+						metrics.caretOffset = caretOffset;
+
+						for(vint i = metrics.start; i <= metrics.end; i++)
+						{
+							int x = 0;
+							pango_layout_line_index_to_x(line, charToByte[i], FALSE, &x);
+							lineCaretX[caretOffset++] = PANGO_PIXELS(logical.x + x);
+						}
+					}
+					while(pango_layout_iter_next_line(iter));
+					pango_layout_iter_free(iter);
+
+					int width, height;
+					pango_layout_get_pixel_size(layout, &width, &height);
+					layoutHeight = height;
+				}
+
+				void DestroyRasterCache()
+				{
+					if(rasterCache)
+					{
+						provider->RasterCacheReleased(this);
+						ReleaseRasterCache();
+					}
+				}
+
+				bool CreateRasterCache()
+				{
+					PangoRectangle ink, logical;
+					pango_layout_get_pixel_extents(layout, &ink, &logical);
+					vint x1 = ink.x < logical.x ? ink.x : logical.x;
+					vint y1 = ink.y < logical.y ? ink.y : logical.y;
+					vint x2 = ink.x + ink.width > logical.x + logical.width ? ink.x + ink.width : logical.x + logical.width;
+					vint y2 = ink.y + ink.height > logical.y + logical.height ? ink.y + ink.height : logical.y + logical.height;
+
+					rasterBounds = Rect(x1, y1, x2, y2);
+					vint pixels = rasterBounds.Width() * rasterBounds.Height();
+					if(pixels <= 0 || pixels > MaxRasterCachePixels) return false;
+
+					//Never drawn into again once created, a changed layout gets a new cache
+					rasterCache = renderTarget->CreateCacheSurface(rasterBounds.GetSize());
+					cairo_t* cacheContext = cairo_create(rasterCache);
+					helpers::ColorSet(cacheContext, Color(0, 0, 0));
+					cairo_move_to(cacheContext, -rasterBounds.x1, -rasterBounds.y1);
+					pango_cairo_show_layout(cacheContext, layout);
+					cairo_destroy(cacheContext);
+					return true;
+				}
+
+				void EnsureLayout()
+				{
+					if(attributesDirty || geometryDirty)
+					{
+						DestroyRasterCache();
+					}
+
+					if(attributesDirty)
+					{
+						ApplyAttributes();
+						attributesDirty = false;
+					}
+
+					if(geometryDirty)
+					{
+						pango_layout_set_width(layout, wrapLine && maxWidth >= 0 ? maxWidth * PANGO_SCALE : -1);
+						switch(paragraphAlignment)
+						{
+						case Alignment::Center:
+							pango_layout_set_alignment(layout, PANGO_ALIGN_CENTER);
+							break;
+						case Alignment::Right:
+							pango_layout_set_alignment(layout, PANGO_ALIGN_RIGHT);
+							break;
+						default:
+							pango_layout_set_alignment(layout, PANGO_ALIGN_LEFT);
+						}
+
+						BuildMetrics();
+						geometryDirty = false;
+					}
+				}
+
+				vint GetLineIndex(vint textPos, bool frontSide)
+				{
+					vint start = 0;
+					vint end = lines.Count() - 1;
+					while(start < end)
+					{
+						vint middle = (start + end) / 2;
+						if(lines[middle].end < textPos)
+						{
+							start = middle + 1;
+						}
+						else
+						{
+							end = middle;
+						}
+					}
+
+					if(!frontSide && start + 1 < lines.Count() && lines[start + 1].start <= textPos)
+					{
+						start++;
+					}
+					return start;
+				}
+
+				vint GetCaretX(vint lineIndex, vint textPos)
+				{
+					LineMetrics& line = lines[lineIndex];
+					if(textPos < line.start) textPos = line.start;
+					if(textPos > line.end) textPos = line.end;
+					return lineCaretX[line.caretOffset + textPos - line.start];
+				}
+
+				vint GetCaretFromLineX(vint lineIndex, vint x)
+				{
+					LineMetrics& line = lines[lineIndex];
+					vint result = line.start;
+					vint distance = -1;
+					for(vint i = line.start; i <= line.end; i++)
+					{
+						if(caretStops[i])
+						{
+							vint current = lineCaretX[line.caretOffset + i - line.start] - x;
+							if(current < 0) current = -current;
+							if(distance == -1 || current < distance)
+							{
+								result = i;
+								distance = current;
+							}
+						}
+					}
+					return result;
+				}
+
+				Rect GetInlineObjectBounds(const InlineObject& inlineObject)
+				{
+					vint lineIndex = GetLineIndex(inlineObject.start, false);
+					LineMetrics& line = lines[lineIndex];
+					vint x1 = GetCaretX(lineIndex, inlineObject.start);
+					vint x2 = GetCaretX(lineIndex, inlineObject.start + inlineObject.length);
+					if(x1 > x2)
+					{
+						vint x = x1;
+						x1 = x2;
+						x2 = x;
+					}
+
+					Size size = inlineObject.properties.size;
+					vint y = line.y2 - size.y;
+					return Rect(Point(x1, y < line.y1 ? line.y1 : y), Size(x2 - x1, size.y));
+				}
+
+			public:
+				static const vint					MaxRasterCachePixels = 1024 * 1024;
+
+				X11CairoParagraph(X11CairoLayoutProvider* _provider, const WString& _text, IGuiGraphicsRenderTarget* _renderTarget):
+					provider(_provider),
+					renderTarget(dynamic_cast<IX11CairoRenderTarget*>(_renderTarget)),
+					paragraphText(_text),
+					layout(NULL),
+					attrList(NULL),
+					wrapLine(true),
+					maxWidth(-1),
+					paragraphAlignment(Alignment::Left),
+					caret(-1),
+					caretFrontSide(false),
+					attributesDirty(true),
+					geometryDirty(true),
+					layoutHeight(0),
+					rasterCache(NULL)
+				{
+					utf8Text = helpers::WStringToUtf8(paragraphText.Buffer(), paragraphText.Length(), &charToByte);
+
+					cairo_t* context = renderTarget ? renderTarget->GetCairoContext() : NULL;
+					layout = helpers::CreatePangoLayout(context);
+
+					PangoFontDescription* desc = helpers::CreateFontDescription(GetCurrentController()->ResourceService()->GetDefaultFont());
+					pango_layout_set_font_description(layout, desc);
+					pango_font_description_free(desc);
+
+					pango_layout_set_wrap(layout, PANGO_WRAP_WORD_CHAR);
+					pango_layout_set_text(layout, utf8Text.Buffer(), utf8Text.Length());
+					attrList = pango_attr_list_new();
+				}
+
+				~X11CairoParagraph()
+				{
+					CloseCaret();
+					DestroyRasterCache();
+					for(vint i = 0; i < inlineObjects.Count(); i++)
+					{
+						if(inlineObjects[i].properties.backgroundImage)
+						{
+							IGuiGraphicsRenderer* renderer = inlineObjects[i].properties.backgroundImage->GetRenderer();
+							if(renderer) renderer->SetRenderTarget(NULL);
+						}
+					}
+
+					pango_attr_list_unref(attrList);
+					g_object_unref(layout);
+				}
+
+				vint GetRasterCacheBytes()
+				{
+					return rasterBounds.Width() * rasterBounds.Height() * 4;
+				}
+
+				void ReleaseRasterCache()
+				{
+					cairo_surface_destroy(rasterCache);
+					rasterCache = NULL;
+				}
+
+				IGuiGraphicsLayoutProvider* GetProvider()override
+				{
+					return provider;
+				}
+
+				IGuiGraphicsRenderTarget* GetRenderTarget()override
+				{
+					return renderTarget;
+				}
+
+				bool GetWrapLine()override
+				{
+					return wrapLine;
+				}
+
+				void SetWrapLine(bool value)override
+				{
+					if(wrapLine != value)
+					{
+						wrapLine = value;
+						geometryDirty = true;
+					}
+				}
+
+				vint GetMaxWidth()override
+				{
+					return maxWidth;
+				}
+
+				void SetMaxWidth(vint value)override
+				{
+					if(maxWidth != value)
+					{
+						maxWidth = value;
+						geometryDirty = true;
+					}
+				}
+
+				Alignment GetParagraphAlignment()override
+				{
+					return paragraphAlignment;
+				}
+
+				void SetParagraphAlignment(Alignment value)override
+				{
+					if(paragraphAlignment != value)
+					{
+						paragraphAlignment = value;
+						geometryDirty = true;
+					}
+				}
+
+				bool SetFont(vint start, vint length, const WString& value)override
+				{
+					if(!CheckRange(start, length)) return false;
+					AString family = helpers::WStringToUtf8(value.Buffer(), value.Length());
+					ChangeAttribute(start, length, pango_attr_family_new(family.Buffer()));
+					attributesDirty = true;
+					geometryDirty = true;
+					return true;
+				}
+
+				bool SetSize(vint start, vint length, vint value)override
+				{
+					if(!CheckRange(start, length)) return false;
+					ChangeAttribute(start, length, pango_attr_size_new_absolute(value * PANGO_SCALE));
+					attributesDirty = true;
+					geometryDirty = true;
+					return true;
+				}
+
+				bool SetStyle(vint start, vint length, TextStyle value)override
+				{
+					if(!CheckRange(start, length)) return false;
+					ChangeAttribute(start, length, pango_attr_weight_new((value & Bold) ? PANGO_WEIGHT_BOLD : PANGO_WEIGHT_MEDIUM));
+					ChangeAttribute(start, length, pango_attr_style_new((value & Italic) ? PANGO_STYLE_ITALIC : PANGO_STYLE_NORMAL));
+					ChangeAttribute(start, length, pango_attr_underline_new((value & Underline) ? PANGO_UNDERLINE_SINGLE : PANGO_UNDERLINE_NONE));
+					ChangeAttribute(start, length, pango_attr_strikethrough_new((value & Strikeline) ? TRUE : FALSE));
+					attributesDirty = true;
+					geometryDirty = true;
+					return true;
+				}
+
+				bool SetColor(vint start, vint length, Color value)override
+				{
+					if(!CheckRange(start, length)) return false;
+					ChangeAttribute(start, length, pango_attr_foreground_new(value.r * 257, value.g * 257, value.b * 257));
+					ChangeAttribute(start, length, pango_attr_foreground_alpha_new(value.a * 257));
+					attributesDirty = true;
+					return true;
+				}
+
+				bool SetBackgroundColor(vint start, vint length, Color value)override
+				{
+					if(!CheckRange(start, length)) return false;
+					ChangeAttribute(start, length, pango_attr_background_new(value.r * 257, value.g * 257, value.b * 257));
+					ChangeAttribute(start, length, pango_attr_background_alpha_new(value.a * 257));
+					attributesDirty = true;
+					return true;
+				}
+
+				bool SetInlineObject(vint start, vint length, const InlineObjectProperties& properties)override
+				{
+					if(!CheckRange(start, length) || length == 0) return false;
+					FOREACH(InlineObject, inlineObject, inlineObjects)
+					{
+						if(inlineObject.start < start + length && start < inlineObject.start + inlineObject.length)
+						{
+							return false;
+						}
+					}
+
+					InlineObject inlineObject;
+					inlineObject.start = start;
+					inlineObject.length = length;
+					inlineObject.properties = properties;
+					inlineObjects.Add(inlineObject);
+
+					if(properties.backgroundImage)
+					{
+						IGuiGraphicsRenderer* renderer = properties.backgroundImage->GetRenderer();
+						if(renderer) renderer->SetRenderTarget(renderTarget);
+					}
+
+					attributesDirty = true;
+					geometryDirty = true;
+					return true;
+				}
+
+				bool ResetInlineObject(vint start, vint length)override
+				{
+					for(vint i = 0; i < inlineObjects.Count(); i++)
+					{
+						InlineObject& inlineObject = inlineObjects[i];
+						if(inlineObject.start == start && inlineObject.length == length)
+						{
+							if(inlineObject.properties.backgroundImage)
+							{
+								IGuiGraphicsRenderer* renderer = inlineObject.properties.backgroundImage->GetRenderer();
+								if(renderer) renderer->SetRenderTarget(NULL);
+							}
+
+							inlineObjects.RemoveAt(i);
+							attributesDirty = true;
+							geometryDirty = true;
+							return true;
+						}
+					}
+					return false;
+				}
+
+				vint GetHeight()override
+				{
+					EnsureLayout();
+					return layoutHeight;
+				}
+
+				bool OpenCaret(vint _caret, Color _color, bool _frontSide)override
+				{
+					if(!IsValidCaret(_caret)) return false;
+					caret = _caret;
+					caretColor = _color;
+					caretFrontSide = _frontSide;
+					return true;
+				}
+
+				bool CloseCaret()override
+				{
+					if(caret == -1) return false;
+					caret = -1;
+					return true;
+				}
+
+				void Render(Rect bounds)override
+				{
+					cairo_t* context = renderTarget ? renderTarget->GetCairoContext() : NULL;
+					if(!context) return;
+
+					EnsureLayout();
+
+					//Paragraphs outside of the clip are skipped without touching the cache
+					double clipX1, clipY1, clipX2, clipY2;
+					cairo_clip_extents(context, &clipX1, &clipY1, &clipX2, &clipY2);
+					if(bounds.y1 >= clipY2 || bounds.y1 + layoutHeight <= clipY1)
+					{
+						return;
+					}
+
+					cairo_save(context);
+					if(!rasterCache)
+					{
+						pango_cairo_update_layout(context, layout);
+						if(!CreateRasterCache())
+						{
+							helpers::ColorSet(context, Color(0, 0, 0));
+							cairo_move_to(context, bounds.x1, bounds.y1);
+							pango_cairo_show_layout(context, layout);
+						}
+					}
+
+					if(rasterCache)
+					{
+						provider->RasterCacheUsed(this);
+						vint x = bounds.x1 + rasterBounds.x1;
+						vint y = bounds.y1 + rasterBounds.y1;
+						cairo_set_source_surface(context, rasterCache, x, y);
+						cairo_rectangle(context, x, y, rasterBounds.Width(), rasterBounds.Height());
+						cairo_fill(context);
+					}
+
+					FOREACH(InlineObject, inlineObject, inlineObjects)
+					{
+						if(inlineObject.properties.backgroundImage)
+						{
+							IGuiGraphicsRenderer* renderer = inlineObject.properties.backgroundImage->GetRenderer();
+							if(renderer)
+							{
+								Rect objectBounds = GetInlineObjectBounds(inlineObject);
+								objectBounds.x1 += bounds.x1;
+								objectBounds.x2 += bounds.x1;
+								objectBounds.y1 += bounds.y1;
+								objectBounds.y2 += bounds.y1;
+								if(objectBounds.x1 < clipX2 && objectBounds.x2 > clipX1 && objectBounds.y1 < clipY2 && objectBounds.y2 > clipY1)
+								{
+									renderer->Render(objectBounds);
+								}
+							}
+						}
+					}
+
+					if(caret != -1)
+					{
+						Rect caretBounds = GetCaretBounds(caret, caretFrontSide);
+						cairo_rectangle(context, bounds.x1 + caretBounds.x1, bounds.y1 + caretBounds.y1, 1, caretBounds.Height());
+						helpers::SolidFill(context, caretColor);
+					}
+					cairo_restore(context);
+				}
+
+				vint GetCaret(vint comparingCaret, CaretRelativePosition position, bool& preferFrontSide)override
+				{
+					if(!IsValidCaret(comparingCaret)) return -1;
+
+					vint length = paragraphText.Length();
+					switch(position)
+					{
+					case CaretFirst:
+						preferFrontSide = false;
+						return 0;
+					case CaretLast:
+						preferFrontSide = true;
+						return length;
+					case CaretLineFirst:
+						{
+							vint lineIndex = GetLineIndex(comparingCaret, preferFrontSide);
+							preferFrontSide = false;
+							return lines[lineIndex].start;
+						}
+					case CaretLineLast:
+						{
+							vint lineIndex = GetLineIndex(comparingCaret, preferFrontSide);
+							preferFrontSide = true;
+							return lines[lineIndex].end;
+						}
+					case CaretMoveLeft:
+						{
+							preferFrontSide = false;
+							for(vint i = comparingCaret - 1; i >= 0; i--)
+							{
+								if(caretStops[i]) return i;
+							}
+							return 0;
+						}
+					case CaretMoveRight:
+						{
+							preferFrontSide = false;
+							for(vint i = comparingCaret + 1; i <= length; i++)
+							{
+								if(caretStops[i]) return i;
+							}
+							return length;
+						}
+					case CaretMoveUp:
+					case CaretMoveDown:
+						{
+							vint lineIndex = GetLineIndex(comparingCaret, preferFrontSide);
+							vint x = GetCaretX(lineIndex, comparingCaret);
+							vint targetIndex = position == CaretMoveUp ? lineIndex - 1 : lineIndex + 1;
+							if(targetIndex < 0 || targetIndex >= lines.Count()) return comparingCaret;
+
+							vint result = GetCaretFromLineX(targetIndex, x);
+							preferFrontSide = result == lines[targetIndex].end;
+							return result;
+						}
+					}
+					return -1;
+				}
+
+				Rect GetCaretBounds(vint caret, bool frontSide)override
+				{
+					if(!IsValidCaret(caret)) return Rect();
+
+					vint lineIndex = GetLineIndex(caret, frontSide);
+					vint x = GetCaretX(lineIndex, caret);
+					return Rect(x, lines[lineIndex].y1, x, lines[lineIndex].y2);
+				}
+
+				vint GetCaretFromPoint(Point point)override
+				{
+					EnsureLayout();
+
+					vint start = 0;
+					vint end = lines.Count() - 1;
+					while(start < end)
+					{
+						vint middle = (start + end) / 2;
+						if(lines[middle].y2 <= point.y)
+						{
+							start = middle + 1;
+						}
+						else
+						{
+							end = middle;
+						}
+					}
+					return GetCaretFromLineX(start, point.x);
+				}
+
+				Nullable<InlineObjectProperties> GetInlineObjectFromPoint(Point point, vint& start, vint& length)override
+				{
+					EnsureLayout();
+
+					FOREACH(InlineObject, inlineObject, inlineObjects)
+					{
+						Rect objectBounds = GetInlineObjectBounds(inlineObject);
+						if(objectBounds.Contains(point))
+						{
+							start = inlineObject.start;
+							length = inlineObject.length;
+							return inlineObject.properties;
+						}
+					}
+					return Nullable<InlineObjectProperties>();
+				}
+
+				vint GetNearestCaretFromTextPos(vint textPos, bool frontSide)override
+				{
+					if(!IsValidTextPos(textPos)) return -1;
+					EnsureLayout();
+					if(caretStops[textPos]) return textPos;
+
+					vint backward = textPos;
+					vint forward = textPos;
+					while(!caretStops[backward]) backward--;
+					while(!caretStops[forward]) forward++;
+
+					if(textPos - backward == forward - textPos)
+					{
+						return frontSide ? backward : forward;
+					}
+					return textPos - backward < forward - textPos ? backward : forward;
+				}
+
+				bool IsValidCaret(vint caret)override
+				{
+					if(!IsValidTextPos(caret)) return false;
+					EnsureLayout();
+					return caretStops[caret];
+				}
+
+				bool IsValidTextPos(vint textPos)override
+				{
+					return 0 <= textPos && textPos <= paragraphText.Length();
+				}
+			};
+
+			X11CairoLayoutProvider::X11CairoLayoutProvider():
+				rasterizedBytes(0)
+			{
+			}
+
+			Ptr<IGuiGraphicsParagraph> X11CairoLayoutProvider::CreateParagraph(const WString& text, IGuiGraphicsRenderTarget* renderTarget)
+			{
+				return new X11CairoParagraph(this, text, renderTarget);
+			}
+
+			void X11CairoLayoutProvider::RasterCacheUsed(X11CairoParagraph* paragraph)
+			{
+				vint index = rasterizedParagraphs.IndexOf(paragraph);
+				if(index != -1)
+				{
+					if(index == rasterizedParagraphs.Count() - 1) return;
+					rasterizedParagraphs.RemoveAt(index);
+				}
+				else
+				{
+					rasterizedBytes += paragraph->GetRasterCacheBytes();
+				}
+				rasterizedParagraphs.Add(paragraph);
+
+				//Paragraphs scrolled away long ago give their surfaces back first
+				while(rasterizedBytes > RasterCacheBudget && rasterizedParagraphs.Count() > 1)
+				{
+					X11CairoParagraph* oldest = rasterizedParagraphs[0];
+					rasterizedParagraphs.RemoveAt(0);
+					rasterizedBytes -= oldest->GetRasterCacheBytes();
+					oldest->ReleaseRasterCache();
+				}
+			}
+
+			void X11CairoLayoutProvider::RasterCacheReleased(X11CairoParagraph* paragraph)
+			{
+				if(rasterizedParagraphs.Remove(paragraph))
+				{
+					rasterizedBytes -= paragraph->GetRasterCacheBytes();
+				}
+			}
+		}
+	}
+}
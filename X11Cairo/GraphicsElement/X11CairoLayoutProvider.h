@@ -0,0 +1,39 @@
+#ifndef __GAC_X11CAIRO_X11_CAIRO_LAYOUT_PROVIDER_H
+#define __GAC_X11CAIRO_X11_CAIRO_LAYOUT_PROVIDER_H
+
+#include <GacUI.h>
+#include "CairoPangoIncludes.h"
+
+namespace vl
+{
+	namespace presentation
+	{
+		namespace elements_x11cairo
+		{
+			using namespace elements;
+
+			class X11CairoParagraph;
+
+			class X11CairoLayoutProvider: public Object, public IGuiGraphicsLayoutProvider
+			{
+			public:
+				static const vint					RasterCacheBudget = 64 * 1024 * 1024;
+
+			protected:
+				//Paragraphs holding a rasterized cache, the least recently drawn one first
+				collections::List<X11CairoParagraph*>	rasterizedParagraphs;
+				vint								rasterizedBytes;
+
+			public:
+				X11CairoLayoutProvider();
+
+				Ptr<IGuiGraphicsParagraph> CreateParagraph(const WString& text, IGuiGraphicsRenderTarget* renderTarget)override;
+
+				void RasterCacheUsed(X11CairoParagraph* paragraph);
+				void RasterCacheReleased(X11CairoParagraph* paragraph);
+			};
+		}
+	}
+}
+
+#endif
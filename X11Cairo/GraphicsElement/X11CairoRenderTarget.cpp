@@ -1,15 +1,19 @@
 #include <vector>
+#include <stdlib.h>
 
 #include "X11CairoRenderTarget.h"
 #include "X11CairoResourceManager.h"
 
 
+using namespace vl::collections;
 using namespace vl::presentation::x11cairo;
 using namespace vl::presentation::elements;
 using namespace vl::presentation::elements_x11cairo;
 
 #ifndef GAC_X11_XCB
 #include "../NativeWindow/Xlib/XlibWindow.h"
+#include "../NativeWindow/Xlib/XlibImageUploader.h"
+#include "../NativeWindow/Common/ServicesImpl/PosixAsyncService.h"
 
 using namespace vl::presentation::x11cairo::xlib;
 #endif
@@ -21,7 +25,32 @@ namespace vl
 		namespace elements_x11cairo
 		{
 
+			static int parallelRendering = -1;
+
+			bool GetX11CairoParallelRendering()
+			{
+				if(parallelRendering == -1)
+				{
+					const char* value = getenv("GAC_X11_PARALLEL_RENDERING");
+					parallelRendering = value && *value && *value != '0' ? 1 : 0;
+				}
+				return parallelRendering == 1;
+			}
+
+			void SetX11CairoParallelRendering(bool value)
+			{
+				parallelRendering = value ? 1 : 0;
+			}
+
 #ifndef GAC_X11_XCB
+			class X11CairoXlibRenderTarget;
+
+			//Shared with worker threads, renderTarget is cleared when the render target is destroyed
+			struct X11CairoParallelState
+			{
+				X11CairoXlibRenderTarget*			renderTarget;
+			};
+
 			class X11CairoXlibRenderTarget: public IX11CairoRenderTarget, INativeWindowListener
 			{
 			private:
@@ -30,10 +59,181 @@ namespace vl
 				XlibWindow* window;
 				std::vector<Rect> clippers;
 
+				//In parallel mode the context draws on an empty unbounded recording surface, every frame is
+				//a group recorded on it and rasterized by a worker into image. Frames finished while a worker is
+				//busy are rasterized together by the next task, only the union of their paint regions is presented.
+				//A queued frame is dropped when a newer one repaints all of its region, and once MaxPendingFrames
+				//are queued the whole window is invalidated once, so the next full frame replaces all of them
+				static const vint MaxPendingFrames = 4;
+				bool parallel;
+				cairo_surface_t* recordingSurface;
+				cairo_surface_t* image;
+				cairo_t* presentContext;
+				Ptr<X11CairoParallelState> parallelState;
+				bool rasterizing;
+				List<Rect> frameRegion;
+				List<cairo_pattern_t*> pendingFrames;
+				List<Ptr<List<Rect>>> pendingFrameRegions;
+				List<Rect> pendingRegion;
+
+				void PresentFrame()
+				{
+					if(window->GetDoubleBuffer())
+					{
+						window->SwapBuffer();
+					}
+
+					//The frame counts as presented once its requests are sent to the server
+					XlibLatencyTracker& latencyTracker = window->GetLatencyTracker();
+					if(latencyTracker.HasPendingInput())
+					{
+						cairo_surface_flush(surface);
+						XFlush(window->GetDisplay());
+						latencyTracker.FramePresented(window->GetWindow());
+					}
+				}
+
+				static void ClipToRegion(cairo_t* context, const List<Rect>& region)
+				{
+					FOREACH(Rect, rect, region)
+					{
+						cairo_rectangle(context, rect.x1, rect.y1, rect.Width(), rect.Height());
+					}
+					cairo_clip(context);
+				}
+
+				static bool CoversRegion(const List<Rect>& newer, const List<Rect>& older)
+				{
+					FOREACH(Rect, rect, older)
+					{
+						bool covered = false;
+						FOREACH(Rect, cover, newer)
+						{
+							if(cover.x1 <= rect.x1 && cover.y1 <= rect.y1 && cover.x2 >= rect.x2 && cover.y2 >= rect.y2)
+							{
+								covered = true;
+								break;
+							}
+						}
+						if(!covered) return false;
+					}
+					return true;
+				}
+
+				void QueueFrame(cairo_pattern_t* frame)
+				{
+					//Only the main thread touches the queue, so dropped frames are destroyed here
+					for(vint i = pendingFrames.Count() - 1; i >= 0; i--)
+					{
+						if(CoversRegion(frameRegion, *pendingFrameRegions[i].Obj()))
+						{
+							cairo_pattern_destroy(pendingFrames[i]);
+							pendingFrames.RemoveAt(i);
+							pendingFrameRegions.RemoveAt(i);
+						}
+					}
+
+					Ptr<List<Rect>> region = new List<Rect>;
+					CopyFrom(*region.Obj(), frameRegion);
+					pendingFrames.Add(frame);
+					pendingFrameRegions.Add(region);
+					CopyFrom(pendingRegion, frameRegion, true);
+
+					if(pendingFrames.Count() == MaxPendingFrames)
+					{
+						window->InvalidateRect(Rect(Point(0, 0), window->GetClientSize()));
+					}
+				}
+
+				void RasterizeFrames()
+				{
+					//No worker uses image here, so it can be replaced, the old content is kept for the parts not repainted
+					Size size(cairo_xlib_surface_get_width(surface), cairo_xlib_surface_get_height(surface));
+					if(!image || cairo_image_surface_get_width(image) != size.x || cairo_image_surface_get_height(image) != size.y)
+					{
+						cairo_surface_t* resized = cairo_image_surface_create(CAIRO_FORMAT_RGB24, size.x, size.y);
+						if(image)
+						{
+							cairo_t* copyContext = cairo_create(resized);
+							cairo_set_source_surface(copyContext, image, 0, 0);
+							cairo_paint(copyContext);
+							cairo_destroy(copyContext);
+							cairo_surface_destroy(image);
+						}
+						image = resized;
+					}
+
+					Ptr<List<cairo_pattern_t*>> frames = new List<cairo_pattern_t*>;
+					Ptr<List<Rect>> region = new List<Rect>;
+					CopyFrom(*frames.Obj(), pendingFrames);
+					CopyFrom(*region.Obj(), pendingRegion);
+					pendingFrames.Clear();
+					pendingFrameRegions.Clear();
+					pendingRegion.Clear();
+
+					//Only image and recording surfaces are touched on the worker, never the display connection.
+					//Frames are destroyed on the main thread, where the caches they reference are created and released
+					rasterizing = true;
+					Ptr<X11CairoParallelState> state = parallelState;
+					cairo_surface_t* target = cairo_surface_reference(image);
+					INativeAsyncService* asyncService = GetCurrentController()->AsyncService();
+					//Frames are latency sensitive, so they go before image decoding and other background work
+					InvokeAsyncWithPriority(asyncService, [=]()
+					{
+						cairo_t* rasterContext = cairo_create(target);
+						ClipToRegion(rasterContext, *region.Obj());
+						FOREACH(cairo_pattern_t*, frame, *frames.Obj())
+						{
+							cairo_set_source(rasterContext, frame);
+							cairo_paint(rasterContext);
+						}
+						cairo_destroy(rasterContext);
+						cairo_surface_flush(target);
+
+						asyncService->InvokeInMainThread([=]()
+						{
+							FOREACH(cairo_pattern_t*, frame, *frames.Obj())
+							{
+								cairo_pattern_destroy(frame);
+							}
+							if(state->renderTarget)
+							{
+								state->renderTarget->FrameRasterized(target, *region.Obj());
+							}
+							cairo_surface_destroy(target);
+						});
+					}, PosixTaskPriority::High);
+				}
+
+				void FrameRasterized(cairo_surface_t* target, const List<Rect>& region)
+				{
+					rasterizing = false;
+					if(target == image)
+					{
+						cairo_save(presentContext);
+						ClipToRegion(presentContext, region);
+						cairo_set_operator(presentContext, CAIRO_OPERATOR_SOURCE);
+						cairo_set_source_surface(presentContext, image, 0, 0);
+						cairo_paint(presentContext);
+						cairo_restore(presentContext);
+						cairo_surface_flush(surface);
+						PresentFrame();
+					}
+
+					if(pendingFrames.Count() > 0)
+					{
+						RasterizeFrames();
+					}
+				}
 
 			public:
 				X11CairoXlibRenderTarget(XlibWindow* window):
-					window(window)
+					window(window),
+					parallel(GetX11CairoParallelRendering()),
+					recordingSurface(NULL),
+					image(NULL),
+					presentContext(NULL),
+					rasterizing(false)
 				{
 					Size size = window->GetClientSize();
 					if(window->GetDoubleBuffer())
@@ -45,7 +245,18 @@ namespace vl
 						surface = cairo_xlib_surface_create(window->GetDisplay(), window->GetWindow(), DefaultVisual(window->GetDisplay(), 0), size.x, size.y);
 					}
 
-					context = cairo_create(surface);
+					if(parallel)
+					{
+						recordingSurface = cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, NULL);
+						context = cairo_create(recordingSurface);
+						presentContext = cairo_create(surface);
+						parallelState = new X11CairoParallelState;
+						parallelState->renderTarget = this;
+					}
+					else
+					{
+						context = cairo_create(surface);
+					}
 
 					if(!surface || !context)
 						throw Exception(L"Failed to create Cairo Surface / Context");
@@ -58,13 +269,27 @@ namespace vl
 				{
 					window->UninstallListener(this);
 
+					if(parallel)
+					{
+						//A frame still rasterizing keeps its own references
+						parallelState->renderTarget = NULL;
+						FOREACH(cairo_pattern_t*, frame, pendingFrames)
+						{
+							cairo_pattern_destroy(frame);
+						}
+						if(image) cairo_surface_destroy(image);
+						cairo_destroy(presentContext);
+						cairo_surface_destroy(recordingSurface);
+					}
+
 					cairo_destroy(context);
 					cairo_surface_destroy(surface);
 				}
 
+				//In parallel mode this is the recording surface of the main thread, caches must use CreateCacheSurface
 				cairo_surface_t* GetCairoSurface()
 				{
-					return surface;
+					return parallel ? recordingSurface : surface;
 				}
 
 				cairo_t* GetCairoContext()
@@ -72,15 +297,89 @@ namespace vl
 					return context;
 				}
 
+				void Invalidate(Rect bounds)
+				{
+					window->InvalidateRect(bounds);
+				}
+
+				cairo_surface_t* CreateCacheSurface(Size size)
+				{
+					//A surface similar to the recording surface would be another recording surface, replayed by
+					//the worker while the main thread records into it
+					return parallel
+						? cairo_image_surface_create(CAIRO_FORMAT_ARGB32, size.x, size.y)
+						: cairo_surface_create_similar(surface, CAIRO_CONTENT_COLOR_ALPHA, size.x, size.y);
+				}
+
+				bool GetParallelRendering()
+				{
+					return parallel;
+				}
+
+				cairo_surface_t* GetImageCache(INativeImageFrame* frame, Size size)
+				{
+					//Pixmaps live on the display connection, which workers must not use
+					if(parallel) return NULL;
+					XlibImageUploader* uploader = GetXlibImageUploader();
+					return uploader ? uploader->GetSurface(frame, size) : NULL;
+				}
+
+				void UploadImage(INativeImageFrame* frame, cairo_surface_t* image)
+				{
+					if(parallel) return;
+					if(XlibImageUploader* uploader = GetXlibImageUploader())
+					{
+						uploader->Upload(frame, image);
+					}
+				}
+
 				void StartRendering()
 				{
+					window->GetLatencyTracker().FrameStarted();
+					if(parallel)
+					{
+						cairo_push_group(context);
+					}
+					cairo_save(context);
+
+					//Inside Paint only the exposed areas need to be drawn
+					const List<Rect>& paintRegion = window->GetPaintRegion();
+					if(parallel)
+					{
+						frameRegion.Clear();
+						if(paintRegion.Count() > 0)
+						{
+							CopyFrom(frameRegion, paintRegion);
+						}
+						else
+						{
+							frameRegion.Add(Rect(Point(0, 0), window->GetClientSize()));
+						}
+					}
+					if(paintRegion.Count() > 0)
+					{
+						FOREACH(Rect, rect, paintRegion)
+						{
+							cairo_rectangle(context, rect.x1, rect.y1, rect.Width(), rect.Height());
+						}
+						cairo_clip(context);
+					}
 				}
 
 				bool StopRendering()
 				{
-					if(window->GetDoubleBuffer())
+					cairo_restore(context);
+					if(parallel)
 					{
-						window->SwapBuffer();
+						QueueFrame(cairo_pop_group(context));
+						if(!rasterizing)
+						{
+							RasterizeFrames();
+						}
+					}
+					else
+					{
+						PresentFrame();
 					}
 
 					return true;
@@ -101,8 +400,8 @@ namespace vl
 					}
 
 					clippers.push_back(clipper);
+					//The clip set by StartRendering is kept, so the new clipper is intersected with it
 					cairo_rectangle(context, clipper.x1, clipper.y1, clipper.Width(), clipper.Height());
-					cairo_reset_clip(context);
 					cairo_clip(context);
 				}
 
@@ -16,8 +16,24 @@ namespace vl
 			public:
 				virtual cairo_surface_t* GetCairoSurface() = 0;
 				virtual cairo_t* GetCairoContext() = 0;
+				virtual void Invalidate(Rect bounds) = 0;
+
+				//Surfaces for caches that are painted into frames. In parallel mode they are image surfaces and a frame
+				//still rasterizing on a worker may read them, so a cache that changes is replaced instead of drawn into again
+				virtual cairo_surface_t* CreateCacheSurface(Size size) = 0;
+				virtual bool GetParallelRendering() = 0;
+
+				//Copies of image frames kept by the display server, NULL until an upload of that size finishes
+				virtual cairo_surface_t* GetImageCache(INativeImageFrame* frame, Size size) = 0;
+				virtual void UploadImage(INativeImageFrame* frame, cairo_surface_t* image) = 0;
 			};
 
+			//When enabled, render targets created afterwards record each frame on the main thread and rasterize it
+			//into a client side image on a worker thread, the main thread only copies finished frames to the window.
+			//The default comes from the GAC_X11_PARALLEL_RENDERING environment variable.
+			extern bool GetX11CairoParallelRendering();
+			extern void SetX11CairoParallelRendering(bool value);
+
 			extern IX11CairoRenderTarget* CreateX11CairoRenderTarget(x11cairo::IX11Window* window);
 			extern void DestroyX11CairoRenderTarget(IX11CairoRenderTarget* target);
 		}
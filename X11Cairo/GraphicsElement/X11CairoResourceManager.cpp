@@ -1,7 +1,11 @@
+#include <math.h>
 #include "X11CairoRenderTarget.h"
 #include "X11CairoResourceManager.h"
+#include "X11CairoLayoutProvider.h"
+#include "Renderers/CairoHelpers.h"
 #include "../NativeWindow/Common/X11Window.h"
 
+using namespace vl::collections;
 using namespace vl::presentation::elements;
 using namespace vl::presentation::elements_x11cairo;
 
@@ -11,8 +15,83 @@ namespace vl
 	{
 		namespace x11cairo
 		{
+			class X11CairoCharMeasurer: public text::CharMeasurer
+			{
+			protected:
+				PangoContext* pangoContext;
+				PangoLayout* layout;
+
+				vint MeasureWidthInternal(wchar_t character, IGuiGraphicsRenderTarget* renderTarget)
+				{
+					AString text = elements_x11cairo::helpers::WStringToUtf8(&character, 1);
+					pango_layout_set_text(layout, text.Buffer(), text.Length());
+
+					int width, height;
+					pango_layout_get_pixel_size(layout, &width, &height);
+					return width;
+				}
+
+				vint GetRowHeightInternal(IGuiGraphicsRenderTarget* renderTarget)
+				{
+					pango_layout_set_text(layout, "0", 1);
+
+					int width, height;
+					pango_layout_get_pixel_size(layout, &width, &height);
+					return height;
+				}
+
+			public:
+				X11CairoCharMeasurer(const FontProperties& font):
+					text::CharMeasurer(font.size)
+				{
+					pangoContext = helpers::CreatePangoContext(NULL);
+					layout = pango_layout_new(pangoContext);
+
+					PangoFontDescription* desc = elements_x11cairo::helpers::CreateFontDescription(font);
+					pango_layout_set_font_description(layout, desc);
+					pango_font_description_free(desc);
+				}
+
+				~X11CairoCharMeasurer()
+				{
+					g_object_unref(layout);
+					g_object_unref(pangoContext);
+				}
+			};
+
 			class X11CairoResourceManager: public elements::GuiGraphicsResourceManager, public IX11CairoResourceManager
 			{
+			protected:
+				Ptr<X11CairoLayoutProvider> layoutProvider;
+				Dictionary<FontProperties, Ptr<X11CairoGlyphTable>> glyphTables;
+				Dictionary<FontProperties, Ptr<text::CharMeasurer>> charMeasurers;
+
+				//Keyed by radius and color, the most recently used one last
+				Dictionary<vuint64_t, cairo_surface_t*> roundBorderCorners;
+				List<vuint64_t> roundBorderCornerOrder;
+				cairo_pattern_t* focusRectanglePattern;
+
+			public:
+				static const vint MaxRoundBorderCornerCount = 64;
+
+				X11CairoResourceManager():
+					focusRectanglePattern(NULL)
+				{
+					layoutProvider = new X11CairoLayoutProvider();
+				}
+
+				~X11CairoResourceManager()
+				{
+					FOREACH(cairo_surface_t*, surface, roundBorderCorners.Values())
+					{
+						cairo_surface_destroy(surface);
+					}
+					if(focusRectanglePattern)
+					{
+						cairo_pattern_destroy(focusRectanglePattern);
+					}
+				}
+
 				IGuiGraphicsRenderTarget* GetRenderTarget(INativeWindow* window)
 				{
 					IX11Window* xWindow = dynamic_cast<IX11Window*>(window);
@@ -38,14 +117,102 @@ namespace vl
 				}
 				IGuiGraphicsLayoutProvider* GetLayoutProvider()
 				{
-					//TODO
-					return NULL;
+					return layoutProvider.Obj();
+				}
+
+				Ptr<X11CairoGlyphTable> GetGlyphTable(cairo_t* context, const FontProperties& font)
+				{
+					vint index = glyphTables.Keys().IndexOf(font);
+					if(index != -1)
+					{
+						return glyphTables.Values().Get(index);
+					}
+
+					Ptr<X11CairoGlyphTable> table = new X11CairoGlyphTable(context, font);
+					glyphTables.Add(font, table);
+					return table;
+				}
+
+				Ptr<text::CharMeasurer> GetCharMeasurer(const FontProperties& font)
+				{
+					vint index = charMeasurers.Keys().IndexOf(font);
+					if(index != -1)
+					{
+						return charMeasurers.Values().Get(index);
+					}
+
+					Ptr<text::CharMeasurer> measurer = new X11CairoCharMeasurer(font);
+					charMeasurers.Add(font, measurer);
+					return measurer;
+				}
+
+				cairo_surface_t* GetRoundBorderCorners(vint radius, Color color)
+				{
+					vuint64_t key = ((vuint64_t)radius << 32) | color.value;
+					vint index = roundBorderCorners.Keys().IndexOf(key);
+					if(index != -1)
+					{
+						roundBorderCornerOrder.Remove(key);
+						roundBorderCornerOrder.Add(key);
+						return roundBorderCorners.Values().Get(index);
+					}
+
+					if(roundBorderCornerOrder.Count() >= MaxRoundBorderCornerCount)
+					{
+						vuint64_t oldest = roundBorderCornerOrder[0];
+						cairo_surface_destroy(roundBorderCorners[oldest]);
+						roundBorderCorners.Remove(oldest);
+						roundBorderCornerOrder.RemoveAt(0);
+					}
+
+					//A circle stroked through the center of its outermost pixels, each quadrant is one corner
+					cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, radius * 2, radius * 2);
+					cairo_t* context = cairo_create(surface);
+					cairo_arc(context, radius, radius, radius - 0.5, 0.0, 2 * M_PI);
+					cairo_set_line_width(context, 1.0);
+					elements_x11cairo::helpers::ColorSet(context, color);
+					cairo_stroke(context);
+					cairo_destroy(context);
+					cairo_surface_flush(surface);
+
+					roundBorderCorners.Add(key, surface);
+					roundBorderCornerOrder.Add(key);
+					return surface;
+				}
+
+				cairo_pattern_t* GetFocusRectanglePattern()
+				{
+					if(!focusRectanglePattern)
+					{
+						cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 2, 2);
+						cairo_t* context = cairo_create(surface);
+						cairo_set_source_rgb(context, 1.0, 1.0, 1.0);
+						cairo_rectangle(context, 0, 0, 1, 1);
+						cairo_rectangle(context, 1, 1, 1, 1);
+						cairo_fill(context);
+						cairo_destroy(context);
+
+						focusRectanglePattern = cairo_pattern_create_for_surface(surface);
+						cairo_pattern_set_extend(focusRectanglePattern, CAIRO_EXTEND_REPEAT);
+						cairo_pattern_set_filter(focusRectanglePattern, CAIRO_FILTER_NEAREST);
+						cairo_surface_destroy(surface);
+					}
+					return focusRectanglePattern;
 				}
 			};
 
+			IX11CairoResourceManager* x11CairoResourceManager = NULL;
+
+			IX11CairoResourceManager* GetX11CairoResourceManager()
+			{
+				return x11CairoResourceManager;
+			}
+
 			void RegisterX11CairoResourceManager()
 			{
-				SetGuiGraphicsResourceManager(new X11CairoResourceManager());
+				X11CairoResourceManager* resourceManager = new X11CairoResourceManager();
+				x11CairoResourceManager = resourceManager;
+				SetGuiGraphicsResourceManager(resourceManager);
 			}
 
 			void UnregisterX11CairoResourceManager()
@@ -53,6 +220,7 @@ namespace vl
 				if(GetGuiGraphicsResourceManager())
 					delete GetGuiGraphicsResourceManager();
 				SetGuiGraphicsResourceManager(NULL);
+				x11CairoResourceManager = NULL;
 			}
 		}
 	}
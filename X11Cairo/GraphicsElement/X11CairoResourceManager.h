@@ -2,6 +2,9 @@
 #define __GAC_X11CAIRO_X11_CAIRO_RESOURCE_MANAGER_H
 
 #include <GacUI.h>
+#include "CairoPangoIncludes.h"
+#include "X11CairoGlyphTable.h"
+
 namespace vl
 {
 	namespace presentation
@@ -10,8 +13,17 @@ namespace vl
 		{
 			class IX11CairoResourceManager: public Interface
 			{
+			public:
+				virtual Ptr<elements_x11cairo::X11CairoGlyphTable>	GetGlyphTable(cairo_t* context, const FontProperties& font) = 0;
+				virtual Ptr<elements::text::CharMeasurer>			GetCharMeasurer(const FontProperties& font) = 0;
+				//A 2r x 2r surface holding the four antialiased corners of a 1 pixel round border,
+				//only valid until the next call
+				virtual cairo_surface_t*							GetRoundBorderCorners(vint radius, Color color) = 0;
+				//A repeating 2x2 checker of opaque white pixels, for dotted lines drawn with CAIRO_OPERATOR_DIFFERENCE
+				virtual cairo_pattern_t*							GetFocusRectanglePattern() = 0;
 			};
 
+			extern IX11CairoResourceManager* GetX11CairoResourceManager();
 			extern void RegisterX11CairoResourceManager();
 			extern void UnregisterX11CairoResourceManager();
 		}
@@ -0,0 +1,19 @@
+#include <time.h>
+
+#include "MonotonicTime.h"
+
+namespace vl
+{
+	namespace presentation
+	{
+		namespace x11cairo
+		{
+			vuint64_t GetMonotonicTime()
+			{
+				struct timespec now;
+				clock_gettime(CLOCK_MONOTONIC, &now);
+				return (vuint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+			}
+		}
+	}
+}
@@ -0,0 +1,19 @@
+#ifndef __GAC_X11CAIRO_MONOTONIC_TIME_H
+#define __GAC_X11CAIRO_MONOTONIC_TIME_H
+
+#include <GacUI.h>
+
+namespace vl
+{
+	namespace presentation
+	{
+		namespace x11cairo
+		{
+			//Microseconds from CLOCK_MONOTONIC, not affected by changes to the wall clock.
+			//Every deadline of the event loop, the timers and the task queues uses this clock
+			extern vuint64_t GetMonotonicTime();
+		}
+	}
+}
+
+#endif
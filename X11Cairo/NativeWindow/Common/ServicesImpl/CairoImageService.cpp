@@ -0,0 +1,851 @@
+#include <string.h>
+
+#include "CairoImageService.h"
+#include "PosixAsyncService.h"
+
+using namespace vl::collections;
+using namespace vl::stream;
+
+namespace vl
+{
+	namespace presentation
+	{
+		namespace x11cairo
+		{
+			namespace
+			{
+				vint ReadUInt16(const vuint8_t* data)
+				{
+					return (vint)data[0] | ((vint)data[1] << 8);
+				}
+
+				vuint32_t ReadUInt32(const vuint8_t* data)
+				{
+					return (vuint32_t)data[0] | ((vuint32_t)data[1] << 8) | ((vuint32_t)data[2] << 16) | ((vuint32_t)data[3] << 24);
+				}
+
+				vuint32_t ReadUInt32BigEndian(const vuint8_t* data)
+				{
+					return ((vuint32_t)data[0] << 24) | ((vuint32_t)data[1] << 16) | ((vuint32_t)data[2] << 8) | (vuint32_t)data[3];
+				}
+
+				vuint32_t Premultiply(vuint32_t r, vuint32_t g, vuint32_t b, vuint32_t a)
+				{
+					if(a != 255)
+					{
+						r = (r * a + 127) / 255;
+						g = (g * a + 127) / 255;
+						b = (b * a + 127) / 255;
+					}
+					return (a << 24) | (r << 16) | (g << 8) | b;
+				}
+
+				//Binary PGM and PPM files, returns the offset of the pixels or -1
+				vint ReadPnmHeader(const vuint8_t* data, vint length, vint& width, vint& height, vint& maxValue)
+				{
+					if(length < 2 || data[0] != 'P' || (data[1] != '5' && data[1] != '6')) return -1;
+
+					vint values[3];
+					vint position = 2;
+					for(vint i = 0; i < 3; i++)
+					{
+						while(position < length)
+						{
+							if(data[position] == '#')
+							{
+								while(position < length && data[position] != '\n') position++;
+							}
+							else if(data[position] == ' ' || data[position] == '\t' || data[position] == '\r' || data[position] == '\n')
+							{
+								position++;
+							}
+							else break;
+						}
+
+						if(position >= length || data[position] < '0' || data[position] > '9') return -1;
+						values[i] = 0;
+						while(position < length && data[position] >= '0' && data[position] <= '9')
+						{
+							values[i] = values[i] * 10 + (data[position++] - '0');
+							if(values[i] > 65535) return -1;
+						}
+					}
+
+					width = values[0];
+					height = values[1];
+					maxValue = values[2];
+					if(width <= 0 || height <= 0 || maxValue <= 0 || maxValue > 255 || position >= length) return -1;
+					return position + 1;
+				}
+
+				bool ReadImageHeader(const vuint8_t* data, vint length, INativeImage::FormatType& format, Size& size)
+				{
+					static const vuint8_t pngSignature[] = { 0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A };
+					if(length >= 24 && memcmp(data, pngSignature, sizeof(pngSignature)) == 0)
+					{
+						format = INativeImage::Png;
+						size = Size(ReadUInt32BigEndian(data + 16), ReadUInt32BigEndian(data + 20));
+						return size.x > 0 && size.y > 0;
+					}
+
+					if(length >= 54 && data[0] == 'B' && data[1] == 'M')
+					{
+						vint height = (vint)(vint32_t)ReadUInt32(data + 22);
+						format = INativeImage::Bmp;
+						size = Size((vint)(vint32_t)ReadUInt32(data + 18), height < 0 ? -height : height);
+						return size.x > 0 && size.y > 0;
+					}
+
+					vint width, height, maxValue;
+					if(ReadPnmHeader(data, length, width, height, maxValue) != -1)
+					{
+						format = INativeImage::Unknown;
+						size = Size(width, height);
+						return true;
+					}
+					return false;
+				}
+
+				vint GetSurfaceBytes(cairo_surface_t* surface)
+				{
+					return cairo_image_surface_get_stride(surface) * cairo_image_surface_get_height(surface);
+				}
+
+				//Area averaging weights of one axis, every target pixel covers an equal span of source pixels
+				struct BoxFilter
+				{
+					Array<vint>			first;
+					Array<vint>			offsets;
+					List<float>			weights;
+
+					BoxFilter(vint sourceLength, vint targetLength)
+						:first(targetLength)
+						,offsets(targetLength + 1)
+					{
+						double scale = (double)sourceLength / targetLength;
+						for(vint i = 0; i < targetLength; i++)
+						{
+							double start = i * scale;
+							double end = (i + 1) * scale;
+							first[i] = (vint)start;
+							offsets[i] = weights.Count();
+							for(vint j = first[i]; j < end && j < sourceLength; j++)
+							{
+								double covered = (end < j + 1 ? end : j + 1) - (start > j ? start : j);
+								weights.Add((float)(covered / scale));
+							}
+						}
+						offsets[targetLength] = weights.Count();
+					}
+				};
+
+				struct PngReader
+				{
+					const vuint8_t*		data;
+					vint				length;
+					vint				position;
+				};
+
+				cairo_status_t ReadPngData(void* closure, unsigned char* buffer, unsigned int length)
+				{
+					PngReader* reader = (PngReader*)closure;
+					if(reader->position + (vint)length > reader->length) return CAIRO_STATUS_READ_ERROR;
+					memcpy(buffer, reader->data + reader->position, length);
+					reader->position += length;
+					return CAIRO_STATUS_SUCCESS;
+				}
+
+				cairo_surface_t* DecodePng(const vuint8_t* data, vint length)
+				{
+					PngReader reader = { data, length, 0 };
+					cairo_surface_t* surface = cairo_image_surface_create_from_png_stream(&ReadPngData, &reader);
+					if(cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS)
+					{
+						cairo_surface_destroy(surface);
+						return NULL;
+					}
+					return surface;
+				}
+
+				cairo_surface_t* DecodeBmp(const vuint8_t* data, vint length)
+				{
+					vint pixelOffset = ReadUInt32(data + 10);
+					vint headerSize = ReadUInt32(data + 14);
+					vint width = (vint32_t)ReadUInt32(data + 18);
+					vint height = (vint32_t)ReadUInt32(data + 22);
+					vint bitCount = ReadUInt16(data + 28);
+					vuint32_t compression = ReadUInt32(data + 30);
+					vint colorsUsed = ReadUInt32(data + 46);
+
+					bool topDown = height < 0;
+					if(topDown) height = -height;
+					if(width <= 0 || height <= 0 || headerSize < 40 || 14 + headerSize > length) return NULL;
+					if(bitCount != 1 && bitCount != 4 && bitCount != 8 && bitCount != 24 && bitCount != 32) return NULL;
+
+					//Only uncompressed pixels are supported, 32 bit pixels may come with channel masks
+					vuint32_t masks[4] = { 0x00FF0000, 0x0000FF00, 0x000000FF, 0 };
+					if(compression == 3 && bitCount == 32)
+					{
+						vint maskOffset = headerSize == 40 ? 54 : 14 + 40;
+						if(maskOffset + 12 > length) return NULL;
+						for(vint i = 0; i < 3; i++) masks[i] = ReadUInt32(data + maskOffset + i * 4);
+						if(headerSize >= 56) masks[3] = ReadUInt32(data + 14 + 52);
+					}
+					else if(compression != 0)
+					{
+						return NULL;
+					}
+
+					vint shifts[4];
+					for(vint i = 0; i < 4; i++)
+					{
+						shifts[i] = 0;
+						if(masks[i])
+						{
+							while(!((masks[i] >> shifts[i]) & 1)) shifts[i]++;
+						}
+					}
+
+					const vuint8_t* palette = data + 14 + headerSize;
+					vint paletteCount = bitCount <= 8 ? (colorsUsed ? colorsUsed : (vint)1 << bitCount) : 0;
+					if(palette + paletteCount * 4 > data + length) return NULL;
+
+					vint rowStride = ((width * bitCount + 31) / 32) * 4;
+					if(pixelOffset < 0 || pixelOffset + rowStride * height > length) return NULL;
+
+					cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+					if(cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS)
+					{
+						cairo_surface_destroy(surface);
+						return NULL;
+					}
+
+					cairo_surface_flush(surface);
+					vuint8_t* pixels = cairo_image_surface_get_data(surface);
+					vint stride = cairo_image_surface_get_stride(surface);
+					bool hasAlpha = false;
+
+					for(vint y = 0; y < height; y++)
+					{
+						const vuint8_t* source = data + pixelOffset + rowStride * (topDown ? y : height - 1 - y);
+						vuint32_t* target = (vuint32_t*)(pixels + stride * y);
+						for(vint x = 0; x < width; x++)
+						{
+							vuint32_t r, g, b, a = 255;
+							if(bitCount <= 8)
+							{
+								vint index = (source[x * bitCount / 8] >> (8 - bitCount - (x * bitCount % 8))) & ((1 << bitCount) - 1);
+								if(index >= paletteCount) index = 0;
+								const vuint8_t* color = palette + index * 4;
+								b = color[0];
+								g = color[1];
+								r = color[2];
+							}
+							else if(bitCount == 24)
+							{
+								b = source[x * 3];
+								g = source[x * 3 + 1];
+								r = source[x * 3 + 2];
+							}
+							else
+							{
+								vuint32_t value = ReadUInt32(source + x * 4);
+								r = (value & masks[0]) >> shifts[0];
+								g = (value & masks[1]) >> shifts[1];
+								b = (value & masks[2]) >> shifts[2];
+								a = compression == 0 ? value >> 24 : masks[3] ? (value & masks[3]) >> shifts[3] : 255;
+								if(a) hasAlpha = true;
+							}
+							target[x] = Premultiply(r, g, b, a);
+						}
+					}
+
+					//Most 32 bit bitmaps leave the reserved byte empty, which means opaque
+					if(bitCount == 32 && !hasAlpha)
+					{
+						for(vint y = 0; y < height; y++)
+						{
+							vuint32_t* target = (vuint32_t*)(pixels + stride * y);
+							for(vint x = 0; x < width; x++)
+							{
+								vuint32_t value = ReadUInt32(data + pixelOffset + rowStride * (topDown ? y : height - 1 - y) + x * 4);
+								target[x] = Premultiply((value & masks[0]) >> shifts[0], (value & masks[1]) >> shifts[1], (value & masks[2]) >> shifts[2], 255);
+							}
+						}
+					}
+
+					cairo_surface_mark_dirty(surface);
+					return surface;
+				}
+
+				cairo_surface_t* DecodePnm(const vuint8_t* data, vint length)
+				{
+					vint width, height, maxValue;
+					vint offset = ReadPnmHeader(data, length, width, height, maxValue);
+					if(offset == -1) return NULL;
+
+					vint channels = data[1] == '6' ? 3 : 1;
+					if(offset + width * height * channels > length) return NULL;
+
+					cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, width, height);
+					if(cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS)
+					{
+						cairo_surface_destroy(surface);
+						return NULL;
+					}
+
+					cairo_surface_flush(surface);
+					vuint8_t* pixels = cairo_image_surface_get_data(surface);
+					vint stride = cairo_image_surface_get_stride(surface);
+					const vuint8_t* source = data + offset;
+					for(vint y = 0; y < height; y++)
+					{
+						vuint32_t* target = (vuint32_t*)(pixels + stride * y);
+						for(vint x = 0; x < width; x++)
+						{
+							vuint32_t r = source[0] * 255 / maxValue;
+							vuint32_t g = source[channels == 3 ? 1 : 0] * 255 / maxValue;
+							vuint32_t b = source[channels == 3 ? 2 : 0] * 255 / maxValue;
+							target[x] = Premultiply(r, g, b, 255);
+							source += channels;
+						}
+					}
+
+					cairo_surface_mark_dirty(surface);
+					return surface;
+				}
+			}
+
+/***********************************************************************
+CairoImageFrame
+***********************************************************************/
+
+			CairoImageFrame::CairoImageFrame(CairoImage* _image, Size _size):
+				image(_image),
+				size(_size),
+				surface(NULL),
+				decodeFailed(false),
+				previousDecoded(NULL),
+				nextDecoded(NULL)
+			{
+			}
+
+			CairoImageFrame::~CairoImageFrame()
+			{
+				for(vint i = 0; i < caches.Count(); i++)
+				{
+					caches.Values().Get(i)->OnDetach(this);
+				}
+
+				if(decodeRequest)
+				{
+					decodeRequest->frame = NULL;
+				}
+
+				if(surface)
+				{
+					image->GetCairoImageService()->FrameReleased(this);
+				}
+			}
+
+			vint CairoImageFrame::ReleaseVariant(Ptr<ScaledVariant> variant)
+			{
+				vint bytes = 0;
+				if(variant->request)
+				{
+					variant->request->frame = NULL;
+				}
+				if(variant->surface)
+				{
+					bytes = GetSurfaceBytes(variant->surface);
+					cairo_surface_destroy(variant->surface);
+				}
+				return bytes;
+			}
+
+			vint CairoImageFrame::ReleaseSurfaces()
+			{
+				vint bytes = GetSurfaceBytes(surface);
+				cairo_surface_destroy(surface);
+				surface = NULL;
+
+				FOREACH(Ptr<ScaledVariant>, variant, variants)
+				{
+					bytes += ReleaseVariant(variant);
+				}
+				variants.Clear();
+				return bytes;
+			}
+
+			INativeImage* CairoImageFrame::GetImage()
+			{
+				return image;
+			}
+
+			Size CairoImageFrame::GetSize()
+			{
+				return size;
+			}
+
+			bool CairoImageFrame::SetCache(void* key, Ptr<INativeImageFrameCache> cache)
+			{
+				vint index = caches.Keys().IndexOf(key);
+				if(index != -1)
+				{
+					return false;
+				}
+				caches.Add(key, cache);
+				cache->OnAttach(this);
+				return true;
+			}
+
+			Ptr<INativeImageFrameCache> CairoImageFrame::GetCache(void* key)
+			{
+				vint index = caches.Keys().IndexOf(key);
+				return index == -1 ? 0 : caches.Values().Get(index);
+			}
+
+			Ptr<INativeImageFrameCache> CairoImageFrame::RemoveCache(void* key)
+			{
+				vint index = caches.Keys().IndexOf(key);
+				if(index == -1)
+				{
+					return 0;
+				}
+				Ptr<INativeImageFrameCache> cache = caches.Values().Get(index);
+				cache->OnDetach(this);
+				caches.Remove(key);
+				return cache;
+			}
+
+			bool CairoImageFrame::InstallListener(ICairoImageFrameListener* listener)
+			{
+				if(listeners.Contains(listener))
+				{
+					return false;
+				}
+				listeners.Add(listener);
+				return true;
+			}
+
+			bool CairoImageFrame::UninstallListener(ICairoImageFrameListener* listener)
+			{
+				return listeners.Remove(listener);
+			}
+
+			cairo_surface_t* CairoImageFrame::GetSurface()
+			{
+				CairoImageService* service = image->GetCairoImageService();
+				if(surface)
+				{
+					service->FrameUsed(this);
+				}
+				else
+				{
+					service->Decode(this);
+				}
+				return surface;
+			}
+
+			bool CairoImageFrame::IsDecoding()
+			{
+				return decodeRequest.Obj() != 0;
+			}
+
+			void CairoImageFrame::DecodeFinished(cairo_surface_t* decodedSurface)
+			{
+				decodeRequest = NULL;
+				if(decodedSurface)
+				{
+					surface = decodedSurface;
+					image->GetCairoImageService()->FrameUsed(this);
+				}
+				else
+				{
+					decodeFailed = true;
+				}
+
+				//Listeners may uninstall themselves while being notified
+				List<ICairoImageFrameListener*> notified;
+				CopyFrom(notified, listeners);
+				FOREACH(ICairoImageFrameListener*, listener, notified)
+				{
+					listener->FrameDecoded(this);
+				}
+			}
+
+			cairo_surface_t* CairoImageFrame::GetScaledSurface(Size scaledSize)
+			{
+				if(!surface) return NULL;
+
+				for(vint i = 0; i < variants.Count(); i++)
+				{
+					Ptr<ScaledVariant> variant = variants[i];
+					if(variant->size == scaledSize)
+					{
+						if(!variant->surface) return NULL;
+						if(i > 0)
+						{
+							variants.RemoveAt(i);
+							variants.Insert(0, variant);
+						}
+						image->GetCairoImageService()->FrameUsed(this);
+						return variant->surface;
+					}
+				}
+
+				if(variants.Count() >= MaxVariantCount)
+				{
+					vint bytes = ReleaseVariant(variants[variants.Count() - 1]);
+					variants.RemoveAt(variants.Count() - 1);
+					image->GetCairoImageService()->AddDecodedBytes(this, -bytes);
+				}
+
+				Ptr<ScaledVariant> variant = new ScaledVariant;
+				variant->size = scaledSize;
+				variant->surface = NULL;
+				variant->request = new CairoImageScaleRequest;
+				variant->request->source = cairo_surface_reference(surface);
+				variant->request->size = scaledSize;
+				variant->request->frame = this;
+				variants.Insert(0, variant);
+
+				image->GetCairoImageService()->Scale(variant->request);
+				return NULL;
+			}
+
+			void CairoImageFrame::ScaleFinished(CairoImageScaleRequest* request, cairo_surface_t* scaledSurface)
+			{
+				FOREACH(Ptr<ScaledVariant>, variant, variants)
+				{
+					if(variant->request.Obj() == request)
+					{
+						//A failed variant stays empty so that the size is not scaled again
+						variant->request = NULL;
+						if(scaledSurface)
+						{
+							variant->surface = scaledSurface;
+							image->GetCairoImageService()->AddDecodedBytes(this, GetSurfaceBytes(scaledSurface));
+						}
+						break;
+					}
+				}
+
+				List<ICairoImageFrameListener*> notified;
+				CopyFrom(notified, listeners);
+				FOREACH(ICairoImageFrameListener*, listener, notified)
+				{
+					listener->FrameDecoded(this);
+				}
+			}
+
+/***********************************************************************
+CairoImage
+***********************************************************************/
+
+			CairoImage::CairoImage(CairoImageService* _service, FormatType _format, Ptr<Array<vuint8_t>> _data, Size size):
+				service(_service),
+				format(_format),
+				data(_data)
+			{
+				frame = new CairoImageFrame(this, size);
+			}
+
+			CairoImage::~CairoImage()
+			{
+				frame = NULL;
+			}
+
+			INativeImageService* CairoImage::GetImageService()
+			{
+				return service;
+			}
+
+			INativeImage::FormatType CairoImage::GetFormat()
+			{
+				return format;
+			}
+
+			vint CairoImage::GetFrameCount()
+			{
+				return 1;
+			}
+
+			INativeImageFrame* CairoImage::GetFrame(vint index)
+			{
+				return index == 0 ? frame.Obj() : 0;
+			}
+
+			CairoImageService* CairoImage::GetCairoImageService()
+			{
+				return service;
+			}
+
+			Ptr<Array<vuint8_t>> CairoImage::GetData()
+			{
+				return data;
+			}
+
+/***********************************************************************
+CairoImageService
+***********************************************************************/
+
+			CairoImageService::CairoImageService():
+				cacheBudget(DefaultCacheBudget),
+				decodedBytes(0),
+				firstDecoded(NULL),
+				lastDecoded(NULL)
+			{
+			}
+
+			CairoImageService::~CairoImageService()
+			{
+			}
+
+			void CairoImageService::UnlinkDecoded(CairoImageFrame* frame)
+			{
+				if(frame->previousDecoded) frame->previousDecoded->nextDecoded = frame->nextDecoded;
+				else firstDecoded = frame->nextDecoded;
+				if(frame->nextDecoded) frame->nextDecoded->previousDecoded = frame->previousDecoded;
+				else lastDecoded = frame->previousDecoded;
+				frame->previousDecoded = NULL;
+				frame->nextDecoded = NULL;
+			}
+
+			void CairoImageService::LinkDecoded(CairoImageFrame* frame)
+			{
+				frame->nextDecoded = firstDecoded;
+				if(firstDecoded) firstDecoded->previousDecoded = frame;
+				else lastDecoded = frame;
+				firstDecoded = frame;
+			}
+
+			Ptr<INativeImage> CairoImageService::CreateImageFromFile(const WString& path)
+			{
+				FileStream fileStream(path, FileStream::ReadOnly);
+				if(!fileStream.IsAvailable()) return 0;
+				return CreateImageFromStream(fileStream);
+			}
+
+			Ptr<INativeImage> CairoImageService::CreateImageFromMemory(void* buffer, vint length)
+			{
+				//Only the header is read here, pixels are decoded on a worker thread when first drawn
+				INativeImage::FormatType format;
+				Size size;
+				if(!buffer || !ReadImageHeader((const vuint8_t*)buffer, length, format, size))
+				{
+					return 0;
+				}
+
+				Ptr<Array<vuint8_t>> data = new Array<vuint8_t>(length);
+				memcpy(&(*data)[0], buffer, length);
+				return new CairoImage(this, format, data, size);
+			}
+
+			Ptr<INativeImage> CairoImageService::CreateImageFromStream(stream::IStream& stream)
+			{
+				MemoryStream memoryStream;
+				CopyStream(stream, memoryStream);
+				return CreateImageFromMemory(memoryStream.GetInternalBuffer(), (vint)memoryStream.Size());
+			}
+
+			vint CairoImageService::GetCacheBudget()
+			{
+				return cacheBudget;
+			}
+
+			void CairoImageService::SetCacheBudget(vint value)
+			{
+				cacheBudget = value;
+				while(decodedBytes > cacheBudget && lastDecoded)
+				{
+					FrameReleased(lastDecoded);
+				}
+			}
+
+			vint CairoImageService::GetDecodedBytes()
+			{
+				return decodedBytes;
+			}
+
+			void CairoImageService::Decode(CairoImageFrame* frame)
+			{
+				if(frame->decodeRequest || frame->decodeFailed) return;
+
+				Ptr<CairoImageDecodeRequest> request = new CairoImageDecodeRequest;
+				request->data = frame->image->GetData();
+				request->format = frame->image->GetFormat();
+				request->frame = frame;
+				frame->decodeRequest = request;
+
+				INativeAsyncService* asyncService = GetCurrentController()->AsyncService();
+				InvokeAsyncWithPriority(asyncService, [=]()
+				{
+					cairo_surface_t* decoded = DecodeImage(request.Obj());
+					asyncService->InvokeInMainThread([=]()
+					{
+						//The frame is detached from the request when it is destroyed before decoding finishes
+						if(request->frame)
+						{
+							request->frame->DecodeFinished(decoded);
+						}
+						else if(decoded)
+						{
+							cairo_surface_destroy(decoded);
+						}
+					});
+				}, PosixTaskPriority::Low);
+			}
+
+			void CairoImageService::Scale(Ptr<CairoImageScaleRequest> request)
+			{
+				INativeAsyncService* asyncService = GetCurrentController()->AsyncService();
+				InvokeAsyncWithPriority(asyncService, [=]()
+				{
+					cairo_surface_t* scaled = ScaleImage(request->source, request->size);
+					cairo_surface_destroy(request->source);
+					asyncService->InvokeInMainThread([=]()
+					{
+						if(request->frame)
+						{
+							request->frame->ScaleFinished(request.Obj(), scaled);
+						}
+						else if(scaled)
+						{
+							cairo_surface_destroy(scaled);
+						}
+					});
+				}, PosixTaskPriority::Low);
+			}
+
+			void CairoImageService::FrameUsed(CairoImageFrame* frame)
+			{
+				if(firstDecoded == frame) return;
+
+				if(frame->previousDecoded)
+				{
+					UnlinkDecoded(frame);
+					LinkDecoded(frame);
+				}
+				else
+				{
+					LinkDecoded(frame);
+					AddDecodedBytes(frame, GetSurfaceBytes(frame->surface));
+				}
+			}
+
+			void CairoImageService::FrameReleased(CairoImageFrame* frame)
+			{
+				UnlinkDecoded(frame);
+				decodedBytes -= frame->ReleaseSurfaces();
+			}
+
+			void CairoImageService::AddDecodedBytes(CairoImageFrame* frame, vint bytes)
+			{
+				decodedBytes += bytes;
+				while(decodedBytes > cacheBudget && lastDecoded && lastDecoded != frame)
+				{
+					FrameReleased(lastDecoded);
+				}
+			}
+
+			cairo_surface_t* CairoImageService::DecodeImage(CairoImageDecodeRequest* request)
+			{
+				const vuint8_t* data = &(*request->data)[0];
+				vint length = request->data->Count();
+				switch(request->format)
+				{
+				case INativeImage::Png:
+					return DecodePng(data, length);
+				case INativeImage::Bmp:
+					return DecodeBmp(data, length);
+				default:
+					return DecodePnm(data, length);
+				}
+			}
+
+			cairo_surface_t* CairoImageService::ScaleImage(cairo_surface_t* source, Size size)
+			{
+				cairo_format_t format = cairo_image_surface_get_format(source);
+				if(format != CAIRO_FORMAT_ARGB32 && format != CAIRO_FORMAT_RGB24) return NULL;
+
+				vint sourceWidth = cairo_image_surface_get_width(source);
+				vint sourceHeight = cairo_image_surface_get_height(source);
+				vint sourceStride = cairo_image_surface_get_stride(source);
+				const vuint8_t* sourcePixels = cairo_image_surface_get_data(source);
+				if(size.x <= 0 || size.y <= 0 || size.x > sourceWidth || size.y > sourceHeight) return NULL;
+
+				cairo_surface_t* surface = cairo_image_surface_create(format, size.x, size.y);
+				if(cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS)
+				{
+					cairo_surface_destroy(surface);
+					return NULL;
+				}
+
+				//Pixels are premultiplied, so averaging every channel independently is correct
+				BoxFilter horizontal(sourceWidth, size.x);
+				BoxFilter vertical(sourceHeight, size.y);
+				//Only the horizontally filtered source rows under the vertical filter are kept, in a ring indexed by source row
+				vint windowRows = 1;
+				for(vint y = 0; y < size.y; y++)
+				{
+					vint count = vertical.offsets[y + 1] - vertical.offsets[y];
+					if(count > windowRows) windowRows = count;
+				}
+				Array<float> rows(size.x * windowRows * 4);
+				vint filteredRows = 0;
+
+				cairo_surface_flush(surface);
+				vuint8_t* pixels = cairo_image_surface_get_data(surface);
+				vint stride = cairo_image_surface_get_stride(surface);
+				for(vint y = 0; y < size.y; y++)
+				{
+					vint lastRow = vertical.first[y] + vertical.offsets[y + 1] - vertical.offsets[y];
+					for(; filteredRows < lastRow; filteredRows++)
+					{
+						const vuint32_t* row = (const vuint32_t*)(sourcePixels + sourceStride * filteredRows);
+						float* target = &rows[size.x * (filteredRows % windowRows) * 4];
+						for(vint x = 0; x < size.x; x++)
+						{
+							float sum[4] = { 0, 0, 0, 0 };
+							for(vint i = horizontal.offsets[x]; i < horizontal.offsets[x + 1]; i++)
+							{
+								vuint32_t pixel = row[horizontal.first[x] + i - horizontal.offsets[x]];
+								float weight = horizontal.weights[i];
+								sum[0] += weight * (pixel >> 24);
+								sum[1] += weight * ((pixel >> 16) & 0xFF);
+								sum[2] += weight * ((pixel >> 8) & 0xFF);
+								sum[3] += weight * (pixel & 0xFF);
+							}
+							memcpy(target + x * 4, sum, sizeof(sum));
+						}
+					}
+
+					vuint32_t* target = (vuint32_t*)(pixels + stride * y);
+					for(vint x = 0; x < size.x; x++)
+					{
+						float sum[4] = { 0, 0, 0, 0 };
+						for(vint i = vertical.offsets[y]; i < vertical.offsets[y + 1]; i++)
+						{
+							vint sourceRow = vertical.first[y] + i - vertical.offsets[y];
+							const float* source = &rows[(size.x * (sourceRow % windowRows) + x) * 4];
+							float weight = vertical.weights[i];
+							for(vint c = 0; c < 4; c++) sum[c] += weight * source[c];
+						}
+
+						vuint32_t pixel = 0;
+						for(vint c = 0; c < 4; c++)
+						{
+							vint value = (vint)(sum[c] + 0.5f);
+							pixel = (pixel << 8) | (vuint32_t)(value > 255 ? 255 : value);
+						}
+						target[x] = pixel;
+					}
+				}
+
+				cairo_surface_mark_dirty(surface);
+				return surface;
+			}
+		}
+	}
+}
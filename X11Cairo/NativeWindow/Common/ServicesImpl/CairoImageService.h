@@ -0,0 +1,153 @@
+#ifndef __GAC_X11CAIRO_CAIRO_IMAGE_SERVICE_H
+#define __GAC_X11CAIRO_CAIRO_IMAGE_SERVICE_H
+
+#include <GacUI.h>
+#include "../../../GraphicsElement/CairoPangoIncludes.h"
+
+namespace vl
+{
+	namespace presentation
+	{
+		namespace x11cairo
+		{
+			class CairoImageService;
+			class CairoImage;
+			class CairoImageFrame;
+
+			class ICairoImageFrameListener: public Interface
+			{
+			public:
+				virtual void FrameDecoded(CairoImageFrame* frame) = 0;
+			};
+
+			//Encoded bytes and the state of one decoding job, shared with the worker thread
+			struct CairoImageDecodeRequest
+			{
+				Ptr<collections::Array<vuint8_t>>	data;
+				INativeImage::FormatType			format;
+				CairoImageFrame*					frame;
+			};
+
+			struct CairoImageScaleRequest
+			{
+				cairo_surface_t*					source;
+				Size								size;
+				CairoImageFrame*					frame;
+			};
+
+			class CairoImageFrame: public Object, public INativeImageFrame
+			{
+				friend class CairoImageService;
+			protected:
+				CairoImage*													image;
+				Size														size;
+				collections::Dictionary<void*, Ptr<INativeImageFrameCache>>	caches;
+				collections::List<ICairoImageFrameListener*>				listeners;
+
+				cairo_surface_t*											surface;
+				Ptr<CairoImageDecodeRequest>								decodeRequest;
+				bool														decodeFailed;
+
+				//Downscaled copies for stretched drawing, the most recently used one first,
+				//they are released together with the decoded surface
+				struct ScaledVariant
+				{
+					Size								size;
+					cairo_surface_t*					surface;
+					Ptr<CairoImageScaleRequest>			request;
+				};
+				collections::List<Ptr<ScaledVariant>>						variants;
+
+				//Intrusive links of the decoded image cache, the most recently used frame first
+				CairoImageFrame*											previousDecoded;
+				CairoImageFrame*											nextDecoded;
+
+				vint								ReleaseVariant(Ptr<ScaledVariant> variant);
+				vint								ReleaseSurfaces();
+
+			public:
+				static const vint					MaxVariantCount = 4;
+
+				CairoImageFrame(CairoImage* _image, Size _size);
+				~CairoImageFrame();
+
+				INativeImage*						GetImage()override;
+				Size								GetSize()override;
+				bool								SetCache(void* key, Ptr<INativeImageFrameCache> cache)override;
+				Ptr<INativeImageFrameCache>			GetCache(void* key)override;
+				Ptr<INativeImageFrameCache>			RemoveCache(void* key)override;
+
+				bool								InstallListener(ICairoImageFrameListener* listener);
+				bool								UninstallListener(ICairoImageFrameListener* listener);
+
+				//Returns NULL and starts decoding in the background when the frame is not decoded yet
+				cairo_surface_t*					GetSurface();
+				bool								IsDecoding();
+				void								DecodeFinished(cairo_surface_t* decodedSurface);
+
+				//Returns NULL and starts scaling in the background when the variant is not ready yet,
+				//only downscaling is supported
+				cairo_surface_t*					GetScaledSurface(Size scaledSize);
+				void								ScaleFinished(CairoImageScaleRequest* request, cairo_surface_t* scaledSurface);
+			};
+
+			class CairoImage: public Object, public INativeImage
+			{
+			protected:
+				CairoImageService*					service;
+				FormatType							format;
+				Ptr<collections::Array<vuint8_t>>	data;
+				Ptr<CairoImageFrame>				frame;
+
+			public:
+				CairoImage(CairoImageService* _service, FormatType _format, Ptr<collections::Array<vuint8_t>> _data, Size size);
+				~CairoImage();
+
+				INativeImageService*				GetImageService()override;
+				FormatType							GetFormat()override;
+				vint								GetFrameCount()override;
+				INativeImageFrame*					GetFrame(vint index)override;
+
+				CairoImageService*					GetCairoImageService();
+				Ptr<collections::Array<vuint8_t>>	GetData();
+			};
+
+			class CairoImageService: public Object, public INativeImageService
+			{
+			protected:
+				vint								cacheBudget;
+				vint								decodedBytes;
+				CairoImageFrame*					firstDecoded;
+				CairoImageFrame*					lastDecoded;
+
+				void								UnlinkDecoded(CairoImageFrame* frame);
+				void								LinkDecoded(CairoImageFrame* frame);
+
+			public:
+				static const vint					DefaultCacheBudget = 128 * 1024 * 1024;
+
+				CairoImageService();
+				~CairoImageService();
+
+				Ptr<INativeImage>					CreateImageFromFile(const WString& path)override;
+				Ptr<INativeImage>					CreateImageFromMemory(void* buffer, vint length)override;
+				Ptr<INativeImage>					CreateImageFromStream(stream::IStream& stream)override;
+
+				vint								GetCacheBudget();
+				void								SetCacheBudget(vint value);
+				vint								GetDecodedBytes();
+
+				void								Decode(CairoImageFrame* frame);
+				void								Scale(Ptr<CairoImageScaleRequest> request);
+				void								FrameUsed(CairoImageFrame* frame);
+				void								FrameReleased(CairoImageFrame* frame);
+				void								AddDecodedBytes(CairoImageFrame* frame, vint bytes);
+
+				static cairo_surface_t*				DecodeImage(CairoImageDecodeRequest* request);
+				static cairo_surface_t*				ScaleImage(cairo_surface_t* source, Size size);
+			};
+		}
+	}
+}
+
+#endif
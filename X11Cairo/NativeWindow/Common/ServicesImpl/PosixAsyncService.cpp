@@ -7,6 +7,19 @@
 
 #include "PosixAsyncService.h"
 
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#else
+#include <pthread.h>
+#endif
+
 namespace vl {
 
     namespace presentation {
@@ -15,29 +28,21 @@ namespace vl {
 
             using namespace collections;
 
-            PosixAsyncService::TaskItem::TaskItem():
-		            semaphore(0)
-            {
-
-            }
-
-            PosixAsyncService::TaskItem::TaskItem(Semaphore* _semaphore, const Func<void()>& _proc):
-		            semaphore(_semaphore),
-		            proc(_proc)
-            {
+#ifndef __linux__
+            //Without futexes every waiting thread sleeps on one condition, waited tasks are rare enough to share it
+            static pthread_mutex_t taskWaitMutex = PTHREAD_MUTEX_INITIALIZER;
+            static pthread_cond_t taskWaitCondition = PTHREAD_COND_INITIALIZER;
+#endif
 
-            }
-
-            PosixAsyncService::TaskItem::~TaskItem()
-            {
-
-            }
+            PosixAsyncService::TaskNode* PosixAsyncService::freeTaskNodes = 0;
+            SpinLock PosixAsyncService::freeTaskNodesLock;
 
             PosixAsyncService::DelayItem::DelayItem(PosixAsyncService* _service, const Func<void()>& _proc, bool _executeInMainThread, vint milliseconds):
 		            service(_service),
 		            proc(_proc),
 		            status(INativeDelay::Pending),
-		            executeTime(DateTime::LocalTime().Forward(milliseconds)),
+		            executeTime(GetMonotonicTime() + (vuint64_t)milliseconds * 1000),
+		            heapIndex(-1),
 		            executeInMainThread(_executeInMainThread)
             {
 
@@ -59,68 +64,415 @@ namespace vl {
 	            {
 		            if(status==INativeDelay::Pending)
 		            {
-			            executeTime=DateTime::LocalTime().Forward(milliseconds);
-			            return true;
+			            vuint64_t oldTime = executeTime;
+			            executeTime = GetMonotonicTime() + (vuint64_t)milliseconds * 1000;
+			            if(executeTime < oldTime)
+			            {
+				            service->HeapUp(heapIndex);
+			            }
+			            else
+			            {
+				            service->HeapDown(heapIndex);
+			            }
 		            }
+		            else return false;
 	            }
-	            return false;
+	            service->Wakeup();
+	            return true;
             }
 
             bool PosixAsyncService::DelayItem::Cancel()
             {
 	            SPIN_LOCK(service->taskListLock)
 	            {
-		            if(status==INativeDelay::Pending)
+		            if(status==INativeDelay::Pending && heapIndex != -1)
 		            {
-			            if(service->delayItems.Remove(this))
-			            {
-				            status=INativeDelay::Canceled;
-				            return true;
-			            }
+			            service->HeapRemove(heapIndex);
+			            status=INativeDelay::Canceled;
+			            return true;
 		            }
 	            }
 	            return false;
             }
 
-            PosixAsyncService::PosixAsyncService():
-		            mainThreadId(Thread::GetCurrentThreadId())
+            void PosixAsyncService::HeapSwap(vint a, vint b)
+            {
+	            Ptr<DelayItem> item = delayHeap[a];
+	            delayHeap.Set(a, delayHeap[b]);
+	            delayHeap.Set(b, item);
+	            delayHeap[a]->heapIndex = a;
+	            delayHeap[b]->heapIndex = b;
+            }
+
+            void PosixAsyncService::HeapUp(vint index)
+            {
+	            while(index > 0)
+	            {
+		            vint parent = (index - 1) / 2;
+		            if(delayHeap[parent]->executeTime <= delayHeap[index]->executeTime) break;
+		            HeapSwap(parent, index);
+		            index = parent;
+	            }
+            }
+
+            void PosixAsyncService::HeapDown(vint index)
+            {
+	            vint count = delayHeap.Count();
+	            while(true)
+	            {
+		            vint smallest = index;
+		            vint left = index * 2 + 1;
+		            vint right = left + 1;
+		            if(left < count && delayHeap[left]->executeTime < delayHeap[smallest]->executeTime) smallest = left;
+		            if(right < count && delayHeap[right]->executeTime < delayHeap[smallest]->executeTime) smallest = right;
+		            if(smallest == index) break;
+		            HeapSwap(smallest, index);
+		            index = smallest;
+	            }
+            }
+
+            void PosixAsyncService::HeapPush(Ptr<DelayItem> item)
+            {
+	            item->heapIndex = delayHeap.Add(item);
+	            HeapUp(item->heapIndex);
+            }
+
+            Ptr<PosixAsyncService::DelayItem> PosixAsyncService::HeapRemove(vint index)
+            {
+	            Ptr<DelayItem> item = delayHeap[index];
+	            vint last = delayHeap.Count() - 1;
+	            if(index != last)
+	            {
+		            HeapSwap(index, last);
+	            }
+	            delayHeap.RemoveAt(last);
+	            item->heapIndex = -1;
+
+	            //The item moved into the hole may belong either above or below it
+	            if(index < delayHeap.Count())
+	            {
+		            HeapUp(index);
+		            HeapDown(delayHeap[index]->heapIndex);
+	            }
+	            return item;
+            }
+
+            PosixAsyncService::TaskNode* PosixAsyncService::AllocateTaskNode()
+            {
+	            TaskNode* node = 0;
+	            SPIN_LOCK(freeTaskNodesLock)
+	            {
+		            node = freeTaskNodes;
+		            if(node)
+		            {
+			            freeTaskNodes = node->next;
+		            }
+	            }
+	            return node ? node : new TaskNode;
+            }
+
+            void PosixAsyncService::ReleaseTaskNode(TaskNode* node)
+            {
+	            node->proc = Func<void()>();
+	            node->waited = false;
+	            node->state = TaskPending;
+	            SPIN_LOCK(freeTaskNodesLock)
+	            {
+		            node->next = freeTaskNodes;
+		            freeTaskNodes = node;
+	            }
+            }
+
+            void PosixAsyncService::PushTask(TaskNode* node)
+            {
+	            __atomic_store_n(&node->next, (TaskNode*)0, __ATOMIC_RELAXED);
+	            TaskNode* previous = __atomic_exchange_n(&taskHead, node, __ATOMIC_ACQ_REL);
+	            //Until this store the consumer sees the queue end at previous
+	            __atomic_store_n(&previous->next, node, __ATOMIC_RELEASE);
+            }
+
+            PosixAsyncService::TaskNode* PosixAsyncService::PopTask()
+            {
+	            TaskNode* tail = taskTail;
+	            TaskNode* next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+	            if(tail == &taskStub)
+	            {
+		            if(!next) return 0;
+		            taskTail = next;
+		            tail = next;
+		            next = __atomic_load_n(&next->next, __ATOMIC_ACQUIRE);
+	            }
+	            if(next)
+	            {
+		            taskTail = next;
+		            return tail;
+	            }
+
+	            //A producer is between its exchange and its store, the task is picked up on the next wakeup
+	            if(tail != __atomic_load_n(&taskHead, __ATOMIC_ACQUIRE)) return 0;
+
+	            //The last node cannot be popped until something follows it
+	            PushTask(&taskStub);
+	            next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+	            if(next)
+	            {
+		            taskTail = next;
+		            return tail;
+	            }
+	            return 0;
+            }
+
+            PosixAsyncService::TaskNode* PosixAsyncService::PostTask(const Func<void()>& proc, bool waited)
+            {
+	            TaskNode* node = AllocateTaskNode();
+	            node->waited = waited;
+	            node->state = TaskPending;
+	            node->proc = proc;
+	            node->postTime = GetMonotonicTime();
+	            __atomic_add_fetch(&taskDepth, 1, __ATOMIC_RELAXED);
+	            PushTask(node);
+
+	            if(!__atomic_exchange_n(&taskWakeupPending, true, __ATOMIC_SEQ_CST))
+	            {
+		            Wakeup();
+	            }
+	            return node;
+            }
+
+            void PosixAsyncService::RunTask(TaskNode* node)
+            {
+	            if(node->waited)
+	            {
+		            //The waiting thread may have timed out and abandoned the task
+		            int expected = TaskPending;
+		            if(!__atomic_compare_exchange_n(&node->state, &expected, (int)TaskRunning, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+		            {
+			            ReleaseTaskNode(node);
+			            return;
+		            }
+	            }
+
+	            vuint64_t latency = GetMonotonicTime() - node->postTime;
+	            taskMetrics.executedCount++;
+	            taskMetrics.totalLatency += latency;
+	            if(latency > taskMetrics.maxLatency)
+	            {
+		            taskMetrics.maxLatency = latency;
+	            }
+
+	            node->proc();
+	            if(node->waited)
+	            {
+		            //The node belongs to the waiting thread after this store, waking a recycled node is harmless
+		            __atomic_store_n(&node->state, (int)TaskFinished, __ATOMIC_RELEASE);
+		            WakeTask(node);
+	            }
+	            else
+	            {
+		            ReleaseTaskNode(node);
+	            }
+            }
+
+            void PosixAsyncService::WaitTask(TaskNode* node, int state, vuint64_t deadline)
+            {
+#ifdef __linux__
+	            //Returns early when state is no longer the expected value, the caller checks again anyway
+	            struct timespec timeout;
+	            struct timespec* timeoutPointer = 0;
+	            if(deadline != 0 && state == TaskPending)
+	            {
+		            vuint64_t now = GetMonotonicTime();
+		            vuint64_t remaining = deadline > now ? deadline - now : 0;
+		            timeout.tv_sec = remaining / 1000000;
+		            timeout.tv_nsec = (remaining % 1000000) * 1000;
+		            timeoutPointer = &timeout;
+	            }
+	            syscall(SYS_futex, &node->state, FUTEX_WAIT_PRIVATE, state, timeoutPointer, 0, 0);
+#else
+	            //The state is checked again under the mutex, which WakeTask takes before signaling
+	            pthread_mutex_lock(&taskWaitMutex);
+	            if(__atomic_load_n(&node->state, __ATOMIC_ACQUIRE) == state)
+	            {
+		            if(deadline != 0 && state == TaskPending)
+		            {
+			            //Condition variables wait for CLOCK_REALTIME unless a clock can be set on them, which is not portable
+			            vuint64_t now = GetMonotonicTime();
+			            vuint64_t remaining = deadline > now ? deadline - now : 0;
+			            struct timespec timeout;
+			            clock_gettime(CLOCK_REALTIME, &timeout);
+			            vuint64_t nanoseconds = (vuint64_t)timeout.tv_nsec + (remaining % 1000000) * 1000;
+			            timeout.tv_sec += remaining / 1000000 + nanoseconds / 1000000000;
+			            timeout.tv_nsec = nanoseconds % 1000000000;
+			            pthread_cond_timedwait(&taskWaitCondition, &taskWaitMutex, &timeout);
+		            }
+		            else
+		            {
+			            pthread_cond_wait(&taskWaitCondition, &taskWaitMutex);
+		            }
+	            }
+	            pthread_mutex_unlock(&taskWaitMutex);
+#endif
+            }
+
+            void PosixAsyncService::WakeTask(TaskNode* node)
             {
+#ifdef __linux__
+	            syscall(SYS_futex, &node->state, FUTEX_WAKE_PRIVATE, 1, 0, 0, 0);
+#else
+	            //Other nodes share the condition, so every waiting thread wakes up and checks its own node
+	            pthread_mutex_lock(&taskWaitMutex);
+	            pthread_cond_broadcast(&taskWaitCondition);
+	            pthread_mutex_unlock(&taskWaitMutex);
+#endif
+            }
 
+            PosixAsyncService::TaskQueueMetrics PosixAsyncService::GetTaskQueueMetrics()
+            {
+	            TaskQueueMetrics metrics = taskMetrics;
+	            metrics.depth = __atomic_load_n(&taskDepth, __ATOMIC_RELAXED);
+	            return metrics;
+            }
+
+            PosixAsyncService::PosixAsyncService():
+		            taskHead(&taskStub),
+		            taskTail(&taskStub),
+		            taskWakeupPending(false),
+		            taskDepth(0),
+		            mainThreadId(Thread::GetCurrentThreadId()),
+		            wakeupReadFd(-1),
+		            wakeupWriteFd(-1),
+		            threadPool(getenv("GAC_X11_POOL_THREADS") ? atoi(getenv("GAC_X11_POOL_THREADS")) : 0, getenv("GAC_X11_POOL_AFFINITY") != 0)
+            {
+	            taskStub.next = 0;
+	            taskStub.waited = false;
+	            taskStub.state = TaskPending;
+	            taskStub.postTime = 0;
+	            memset(&taskMetrics, 0, sizeof(taskMetrics));
+
+#ifdef __linux__
+	            wakeupReadFd = wakeupWriteFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#endif
+	            if(wakeupReadFd == -1)
+	            {
+		            int fds[2];
+		            if(pipe(fds))
+		            {
+			            throw Exception(L"Unable to create the wakeup pipe");
+		            }
+		            for(int i = 0; i < 2; i++)
+		            {
+			            fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL) | O_NONBLOCK);
+			            fcntl(fds[i], F_SETFD, FD_CLOEXEC);
+		            }
+		            wakeupReadFd = fds[0];
+		            wakeupWriteFd = fds[1];
+	            }
             }
 
             PosixAsyncService::~PosixAsyncService()
             {
+	            while(TaskNode* node = PopTask())
+	            {
+		            delete node;
+	            }
+	            TaskNode* nodes = 0;
+	            SPIN_LOCK(freeTaskNodesLock)
+	            {
+		            nodes = freeTaskNodes;
+		            freeTaskNodes = 0;
+	            }
+	            while(nodes)
+	            {
+		            TaskNode* node = nodes;
+		            nodes = node->next;
+		            delete node;
+	            }
+
+	            close(wakeupReadFd);
+	            if(wakeupWriteFd != wakeupReadFd)
+	            {
+		            close(wakeupWriteFd);
+	            }
+            }
+
+            void PosixAsyncService::Wakeup()
+            {
+	            //A full pipe or a saturated eventfd is already readable, so a failed write loses nothing
+	            vuint64_t value = 1;
+	            ssize_t written = write(wakeupWriteFd, &value, wakeupReadFd == wakeupWriteFd ? sizeof(value) : 1);
+	            (void)written;
+            }
 
+            int PosixAsyncService::GetWakeupHandle()
+            {
+	            return wakeupReadFd;
             }
 
-            void PosixAsyncService::ExecuteAsyncTasks()
+            void PosixAsyncService::ClearWakeup()
             {
-	            DateTime now = DateTime::LocalTime();
-	            Array<TaskItem> items;
-	            List<Ptr<DelayItem>> executableDelayItems;
+	            //Reading an eventfd resets its counter, a pipe is drained until it would block
+	            vuint64_t buffer[16];
+	            while(read(wakeupReadFd, buffer, sizeof(buffer)) > 0)
+	            {
+		            if(wakeupReadFd == wakeupWriteFd) break;
+	            }
+            }
 
+            vuint64_t PosixAsyncService::GetNextDelayTime()
+            {
+	            vuint64_t time = 0;
 	            SPIN_LOCK(taskListLock)
 	            {
-		            CopyFrom(items, taskItems);
-		            taskItems.RemoveRange(0, items.Count());
-		            for(vint i = delayItems.Count()-1;i>=0;i--)
+		            if(delayHeap.Count() > 0)
 		            {
-			            Ptr<DelayItem> item = delayItems[i];
-			            if(now.filetime >= item->executeTime.filetime)
-			            {
-				            item->status = INativeDelay::Executing;
-				            executableDelayItems.Add(item);
-				            delayItems.RemoveAt(i);
-			            }
+			            time = delayHeap[0]->executeTime;
 		            }
 	            }
+	            return time;
+            }
+
+            vint PosixAsyncService::GetNextDelayTimeout()
+            {
+	            vuint64_t time = GetNextDelayTime();
+	            if(time == 0) return -1;
+
+	            //Round up so the delay is never woken early
+	            vuint64_t now = GetMonotonicTime();
+	            return time <= now ? 0 : (vint)((time - now + 999) / 1000);
+            }
+
+            bool PosixAsyncService::ExecuteAsyncTasks()
+            {
+	            vuint64_t now = GetMonotonicTime();
+	            List<Ptr<DelayItem>> executableDelayItems;
+	            bool executed = false;
+
+	            //Tasks posted after this point wake the event loop again
+	            __atomic_store_n(&taskWakeupPending, false, __ATOMIC_SEQ_CST);
+	            vint depth = __atomic_load_n(&taskDepth, __ATOMIC_RELAXED);
+	            if(depth > taskMetrics.maxDepth)
+	            {
+		            taskMetrics.maxDepth = depth;
+	            }
 
-	            FOREACH(TaskItem, item, items)
+	            //Tasks posted by the running tasks wait for the next iteration
+	            for(vint i = 0; i < depth; i++)
 	            {
-		            item.proc();
-		            if(item.semaphore)
+		            TaskNode* node = PopTask();
+		            if(!node) break;
+		            __atomic_sub_fetch(&taskDepth, 1, __ATOMIC_RELAXED);
+		            RunTask(node);
+		            executed = true;
+	            }
+
+	            SPIN_LOCK(taskListLock)
+	            {
+		            //Due delays are popped in the order of their execute time
+		            while(delayHeap.Count() > 0 && delayHeap[0]->executeTime <= now)
 		            {
-			            item.semaphore->Release();
+			            Ptr<DelayItem> item = HeapRemove(0);
+			            item->status = INativeDelay::Executing;
+			            executableDelayItems.Add(item);
 		            }
 	            }
 
@@ -140,6 +492,8 @@ namespace vl {
 			            });
 		            }
 	            }
+
+	            return executed || executableDelayItems.Count() > 0;
             }
 
             bool PosixAsyncService::IsInMainThread()
@@ -149,43 +503,67 @@ namespace vl {
 
             void PosixAsyncService::InvokeAsync(const Func<void()>& proc)
             {
-	            ThreadPoolLite::Queue(proc);
+	            threadPool.Queue(proc, PosixTaskPriority::Normal);
             }
 
-            void PosixAsyncService::InvokeInMainThread(const Func<void()>& proc)
+            void PosixAsyncService::InvokeAsync(const Func<void()>& proc, PosixTaskPriority priority)
             {
-	            SPIN_LOCK(taskListLock)
+	            threadPool.Queue(proc, priority);
+            }
+
+            PosixThreadPool* PosixAsyncService::GetThreadPool()
+            {
+	            return &threadPool;
+            }
+
+            void InvokeAsyncWithPriority(INativeAsyncService* service, const Func<void()>& proc, PosixTaskPriority priority)
+            {
+	            if(PosixAsyncService* posixService = dynamic_cast<PosixAsyncService*>(service))
+	            {
+		            posixService->InvokeAsync(proc, priority);
+	            }
+	            else
 	            {
-		            TaskItem item(0, proc);
-		            taskItems.Add(item);
+		            service->InvokeAsync(proc);
 	            }
             }
 
-            bool PosixAsyncService::InvokeInMainThreadAndWait(const Func<void()>& proc, vint milliseconds)
+            void PosixAsyncService::InvokeInMainThread(const Func<void()>& proc)
             {
-	            Semaphore* semaphore = new Semaphore();
-	            semaphore->Create(0, 1);
+	            PostTask(proc, false);
+            }
 
-	            TaskItem item(semaphore, proc);
-	            SPIN_LOCK(taskListLock)
+            bool PosixAsyncService::InvokeInMainThreadAndWait(const Func<void()>& proc, vint milliseconds)
+            {
+	            //The main thread would wait for itself
+	            if(IsInMainThread())
 	            {
-		            taskItems.Add(item);
+		            proc();
+		            return true;
 	            }
 
-	            // todo, if semphoare fails to wait for some reason
-	            // taskItems will corrupt
-	            return semaphore->Wait();
+	            vuint64_t deadline = milliseconds < 0 ? 0 : GetMonotonicTime() + (vuint64_t)milliseconds * 1000;
+	            TaskNode* node = PostTask(proc, true);
+	            while(true)
+	            {
+		            int state = __atomic_load_n(&node->state, __ATOMIC_ACQUIRE);
+		            if(state == TaskFinished) break;
+
+		            //A task that already started is always waited for
+		            if(state == TaskPending && deadline != 0 && GetMonotonicTime() >= deadline)
+		            {
+			            //The main thread skips and releases an abandoned node when it pops it
+			            if(__atomic_compare_exchange_n(&node->state, &state, (int)TaskAbandoned, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+			            {
+				            return false;
+			            }
+			            continue;
+		            }
+		            WaitTask(node, state, deadline);
+	            }
 
-//                if(milliseconds < 0)
-//                {
-//                    return semaphore.Wait();
-//                }
-//                else
-//                {
-//                    // todo
-//                    return false;
-//                    //return semaphore.WaitForTime(milliseconds);
-//                }
+	            ReleaseTaskNode(node);
+	            return true;
             }
 
             Ptr<INativeDelay> PosixAsyncService::DelayExecute(const Func<void()>& proc, vint milliseconds)
@@ -194,8 +572,9 @@ namespace vl {
 	            SPIN_LOCK(taskListLock)
 	            {
 		            delay = new DelayItem(this, proc, false, milliseconds);
-		            delayItems.Add(delay);
+		            HeapPush(delay);
 	            }
+	            Wakeup();
 	            return delay;
             }
 
@@ -205,8 +584,9 @@ namespace vl {
 	            SPIN_LOCK(taskListLock)
 	            {
 		            delay = new DelayItem(this, proc, true, milliseconds);
-		            delayItems.Add(delay);
+		            HeapPush(delay);
 	            }
+	            Wakeup();
 	            return delay;
             }
 
@@ -8,6 +8,8 @@
 #define __GAC_X11CAIRO_POSIX_ASYNC_SERVICE_H
 
 #include <GacUI.h>
+#include "PosixThreadPool.h"
+#include "../MonotonicTime.h"
 
 namespace vl {
 
@@ -17,15 +19,37 @@ namespace vl {
 
             class PosixAsyncService : public INativeAsyncService
             {
+            public:
+	            struct TaskQueueMetrics
+	            {
+		            //Tasks posted but not started yet, and the most seen by the main thread
+		            vint                    depth;
+		            vint                    maxDepth;
+		            vuint64_t               executedCount;
+		            //Microseconds from posting a task to the main thread starting it
+		            vuint64_t               totalLatency;
+		            vuint64_t               maxLatency;
+	            };
+
             protected:
-	            struct TaskItem
+	            enum TaskState
 	            {
-		            Semaphore*              semaphore;
-		            Func<void()>            proc;
+		            TaskPending,
+		            TaskRunning,
+		            TaskFinished,
+		            TaskAbandoned,
+	            };
 
-		            TaskItem();
-		            TaskItem(Semaphore* _semaphore, const Func<void()>& _proc);
-		            ~TaskItem();
+	            //A node of the intrusive task queue, recycled through a free list instead of being deleted.
+	            //For InvokeInMainThreadAndWait the node is also the completion object, the waiting thread
+	            //sleeps on state and releases the node, unless it gave up first and left that to the main thread
+	            struct TaskNode
+	            {
+		            TaskNode*               next;
+		            bool                    waited;
+		            int                     state;
+		            Func<void()>            proc;
+		            vuint64_t               postTime;
 	            };
 
 	            class DelayItem: public Object, public INativeDelay
@@ -37,7 +61,9 @@ namespace vl {
 		            PosixAsyncService*      service;
 		            Func<void()>            proc;
 		            ExecuteStatus           status;
-		            DateTime                executeTime;
+		            //Microseconds from CLOCK_MONOTONIC, and the position in delayHeap while pending
+		            vuint64_t               executeTime;
+		            vint                    heapIndex;
 		            bool                    executeInMainThread;
 
 		            ExecuteStatus           GetStatus() override;
@@ -45,23 +71,73 @@ namespace vl {
 		            bool                    Cancel() override;
 	            };
 
-	            collections::List<TaskItem>				taskItems;
-	            collections::List<Ptr<DelayItem>>		delayItems;
+	            //A multiple producer single consumer queue, producers only swap taskHead,
+	            //the main thread pops from taskTail, taskStub keeps the queue non-empty
+	            TaskNode*                               taskHead;
+	            TaskNode*                               taskTail;
+	            TaskNode                                taskStub;
+	            //Set by the first task posted after the main thread started draining, so only it writes to the wakeup fd
+	            bool                                    taskWakeupPending;
+	            vint                                    taskDepth;
+	            TaskQueueMetrics                        taskMetrics;
+
+	            //Shared by all threads and emptied by the destructor, a pop and a push are a few instructions under the lock
+	            static TaskNode*                        freeTaskNodes;
+	            static SpinLock                         freeTaskNodesLock;
+	            //A binary min-heap ordered by executeTime, only the top is looked at when nothing is due
+	            collections::List<Ptr<DelayItem>>		delayHeap;
 	            SpinLock								taskListLock;
 	            vint                                    mainThreadId;
+	            //An eventfd (or the read end of a pipe) that becomes readable when the main thread has work to do
+	            int                                     wakeupReadFd;
+	            int                                     wakeupWriteFd;
+	            //Sized by GAC_X11_POOL_THREADS and pinned to processors when GAC_X11_POOL_AFFINITY is set
+	            PosixThreadPool                         threadPool;
+
+	            //The heap is only accessed while holding taskListLock
+	            void                HeapSwap(vint a, vint b);
+	            void                HeapUp(vint index);
+	            void                HeapDown(vint index);
+	            void                HeapPush(Ptr<DelayItem> item);
+	            Ptr<DelayItem>      HeapRemove(vint index);
+
+	            static TaskNode*    AllocateTaskNode();
+	            static void         ReleaseTaskNode(TaskNode* node);
+	            void                PushTask(TaskNode* node);
+	            TaskNode*           PopTask();
+	            TaskNode*           PostTask(const Func<void()>& proc, bool waited);
+	            void                RunTask(TaskNode* node);
+	            static void         WaitTask(TaskNode* node, int state, vuint64_t deadline);
+	            static void         WakeTask(TaskNode* node);
 
             public:
 	            PosixAsyncService();
 	            ~PosixAsyncService();
 
-	            void                ExecuteAsyncTasks();
+	            //Returns false when no task or delay was due
+	            bool                ExecuteAsyncTasks();
+	            //Wakes the event loop, can be called from any thread
+	            void                Wakeup();
+	            int                 GetWakeupHandle();
+	            void                ClearWakeup();
+	            //Only valid on the main thread
+	            TaskQueueMetrics    GetTaskQueueMetrics();
+	            //The monotonic time of the earliest pending delay in microseconds, 0 when there is none
+	            vuint64_t           GetNextDelayTime();
+	            //Milliseconds until the earliest pending delay, -1 when there is none
+	            vint                GetNextDelayTimeout();
 	            bool                IsInMainThread()override;
 	            void                InvokeAsync(const Func<void()>& proc)override;
+	            void                InvokeAsync(const Func<void()>& proc, PosixTaskPriority priority);
+	            PosixThreadPool*    GetThreadPool();
 	            void                InvokeInMainThread(const Func<void()>& proc)override;
 	            bool                InvokeInMainThreadAndWait(const Func<void()>& proc, vint milliseconds)override;
 	            Ptr<INativeDelay>   DelayExecute(const Func<void()>& proc, vint milliseconds)override;
 	            Ptr<INativeDelay>   DelayExecuteInMainThread(const Func<void()>& proc, vint milliseconds)override;
             };
+
+            //Queues with a priority when the service is a PosixAsyncService, otherwise falls back to InvokeAsync
+            extern void InvokeAsyncWithPriority(INativeAsyncService* service, const Func<void()>& proc, PosixTaskPriority priority);
         }
     }
 }
@@ -0,0 +1,268 @@
+#include <limits.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+#include "PosixThreadPool.h"
+#include "../MonotonicTime.h"
+
+using namespace vl::collections;
+
+namespace vl
+{
+	namespace presentation
+	{
+		namespace x11cairo
+		{
+			namespace
+			{
+				vint GetProcessorCount()
+				{
+					long count = sysconf(_SC_NPROCESSORS_ONLN);
+					return count > 0 ? (vint)count : 1;
+				}
+			}
+
+/***********************************************************************
+PosixThreadPool::TaskDeque
+***********************************************************************/
+
+			PosixThreadPool::TaskDeque::TaskDeque():
+				head(0),
+				count(0)
+			{
+			}
+
+			vint PosixThreadPool::TaskDeque::Count()
+			{
+				return count;
+			}
+
+			void PosixThreadPool::TaskDeque::PushBack(const Func<void()>& proc)
+			{
+				vint capacity = items.Count();
+				if(count == capacity)
+				{
+					items.Resize(capacity == 0 ? 16 : capacity * 2);
+					//Tasks wrapped around to the beginning move behind the old end, so the ring continues from head
+					for(vint i = 0; i < head; i++)
+					{
+						items.Set(capacity + i, items.Get(i));
+						items.Set(i, Func<void()>());
+					}
+				}
+				items.Set((head + count) % items.Count(), proc);
+				count++;
+			}
+
+			Func<void()> PosixThreadPool::TaskDeque::PopBack()
+			{
+				count--;
+				vint index = (head + count) % items.Count();
+				Func<void()> proc = items.Get(index);
+				items.Set(index, Func<void()>());
+				return proc;
+			}
+
+			Func<void()> PosixThreadPool::TaskDeque::PopFront()
+			{
+				Func<void()> proc = items.Get(head);
+				items.Set(head, Func<void()>());
+				head = (head + 1) % items.Count();
+				count--;
+				return proc;
+			}
+
+/***********************************************************************
+PosixThreadPool
+***********************************************************************/
+
+			thread_local PosixThreadPool::Worker* PosixThreadPool::currentWorker = 0;
+			thread_local PosixThreadPool* PosixThreadPool::currentPool = 0;
+
+			void PosixThreadPool::Start()
+			{
+				SPIN_LOCK(startLock)
+				{
+					if(!started)
+					{
+						startTime = GetMonotonicTime();
+						for(vint i = 0; i < workers.Count(); i++)
+						{
+							Worker* worker = workers[i];
+							worker->thread = Thread::CreateAndStart([this, worker](){ Run(worker); }, false);
+						}
+						started = true;
+					}
+				}
+			}
+
+			void PosixThreadPool::Run(Worker* worker)
+			{
+				currentWorker = worker;
+				currentPool = this;
+#ifdef __linux__
+				if(affinity)
+				{
+					cpu_set_t set;
+					CPU_ZERO(&set);
+					CPU_SET(worker->index % GetProcessorCount(), &set);
+					pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+				}
+#endif
+
+				while(true)
+				{
+					//Every queued task releases the semaphore once, after it is in a deque,
+					//so there are always at least as many queued tasks as workers passing the semaphore
+					semaphore.Wait();
+					if(stopping) break;
+
+					Func<void()> proc;
+					TakeTask(worker, proc);
+					__atomic_sub_fetch(&pendingCount, 1, __ATOMIC_RELAXED);
+
+					vuint64_t begin = GetMonotonicTime();
+					proc();
+					vuint64_t end = GetMonotonicTime();
+					__atomic_add_fetch(&worker->executedCount, 1, __ATOMIC_RELAXED);
+					__atomic_add_fetch(&worker->busyTime, end - begin, __ATOMIC_RELAXED);
+				}
+			}
+
+			void PosixThreadPool::TakeTask(Worker* worker, Func<void()>& proc)
+			{
+				//A scan only misses when another worker took a task from a deque not searched yet while this one
+				//was searched, so every repeated scan follows progress of another worker, nothing waits for a producer
+				while(true)
+				{
+					for(vint priority = 0; priority < PriorityCount; priority++)
+					{
+						bool found = false;
+						SPIN_LOCK(worker->lock)
+						{
+							TaskDeque& tasks = worker->tasks[priority];
+							if(tasks.Count() > 0)
+							{
+								proc = tasks.PopBack();
+								found = true;
+							}
+						}
+						if(found) return;
+
+						for(vint i = 1; i < workers.Count(); i++)
+						{
+							Worker* victim = workers[(worker->index + i) % workers.Count()];
+							SPIN_LOCK(victim->lock)
+							{
+								TaskDeque& tasks = victim->tasks[priority];
+								if(tasks.Count() > 0)
+								{
+									proc = tasks.PopFront();
+									found = true;
+								}
+							}
+							if(found)
+							{
+								__atomic_add_fetch(&worker->stealCount, 1, __ATOMIC_RELAXED);
+								return;
+							}
+						}
+					}
+				}
+			}
+
+			PosixThreadPool::PosixThreadPool(vint threadCount, bool _affinity):
+				started(false),
+				stopping(false),
+				affinity(_affinity),
+				pendingCount(0),
+				nextWorker(0),
+				startTime(0)
+			{
+				if(threadCount <= 0)
+				{
+					threadCount = GetProcessorCount();
+				}
+
+				workers.Resize(threadCount);
+				for(vint i = 0; i < threadCount; i++)
+				{
+					Worker* worker = new Worker;
+					worker->index = i;
+					worker->thread = 0;
+					worker->executedCount = 0;
+					worker->stealCount = 0;
+					worker->busyTime = 0;
+					workers.Set(i, worker);
+				}
+				semaphore.Create(0, INT_MAX);
+			}
+
+			PosixThreadPool::~PosixThreadPool()
+			{
+				//Tasks not started yet are dropped
+				stopping = true;
+				for(vint i = 0; i < workers.Count(); i++)
+				{
+					semaphore.Release();
+				}
+
+				for(vint i = 0; i < workers.Count(); i++)
+				{
+					Worker* worker = workers[i];
+					if(worker->thread)
+					{
+						worker->thread->Wait();
+						delete worker->thread;
+					}
+					delete worker;
+				}
+			}
+
+			vint PosixThreadPool::GetThreadCount()
+			{
+				return workers.Count();
+			}
+
+			void PosixThreadPool::Queue(const Func<void()>& proc, PosixTaskPriority priority)
+			{
+				if(!started)
+				{
+					Start();
+				}
+
+				Worker* worker = currentPool == this
+					? currentWorker
+					: workers[(vint)((vuint64_t)__atomic_fetch_add(&nextWorker, 1, __ATOMIC_RELAXED) % workers.Count())];
+				//Releasing the lock publishes the task before the semaphore lets a worker look for it
+				SPIN_LOCK(worker->lock)
+				{
+					worker->tasks[(vint)priority].PushBack(proc);
+				}
+				__atomic_add_fetch(&pendingCount, 1, __ATOMIC_RELAXED);
+				semaphore.Release();
+			}
+
+			PosixThreadPoolStatistics PosixThreadPool::GetStatistics()
+			{
+				PosixThreadPoolStatistics statistics;
+				statistics.threadCount = workers.Count();
+				statistics.pendingCount = __atomic_load_n(&pendingCount, __ATOMIC_RELAXED);
+				statistics.executedCount = 0;
+				statistics.stealCount = 0;
+				statistics.busyTime = 0;
+				statistics.elapsedTime = started ? GetMonotonicTime() - startTime : 0;
+				for(vint i = 0; i < workers.Count(); i++)
+				{
+					Worker* worker = workers[i];
+					statistics.executedCount += __atomic_load_n(&worker->executedCount, __ATOMIC_RELAXED);
+					statistics.stealCount += __atomic_load_n(&worker->stealCount, __ATOMIC_RELAXED);
+					statistics.busyTime += __atomic_load_n(&worker->busyTime, __ATOMIC_RELAXED);
+				}
+				return statistics;
+			}
+		}
+	}
+}
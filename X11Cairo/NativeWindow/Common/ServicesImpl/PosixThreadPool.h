@@ -0,0 +1,99 @@
+#ifndef __GAC_X11CAIRO_POSIX_THREAD_POOL_H
+#define __GAC_X11CAIRO_POSIX_THREAD_POOL_H
+
+#include <GacUI.h>
+
+namespace vl
+{
+	namespace presentation
+	{
+		namespace x11cairo
+		{
+			enum class PosixTaskPriority
+			{
+				//Work the user is waiting for, like rasterizing a frame
+				High,
+				Normal,
+				//Background work, like decoding and scaling images
+				Low,
+			};
+
+			struct PosixThreadPoolStatistics
+			{
+				vint								threadCount;
+				vint								pendingCount;
+				vuint64_t							executedCount;
+				vuint64_t							stealCount;
+				//Microseconds spent running tasks summed over all workers, and since the first task was queued
+				vuint64_t							busyTime;
+				vuint64_t							elapsedTime;
+			};
+
+			//Every worker owns one deque for each priority. A worker takes the newest task of its own deque,
+			//otherwise it steals the oldest task of another worker, and tasks of a higher priority always go first.
+			//Tasks queued from a worker stay on its deque, other threads spread them over all workers.
+			class PosixThreadPool: public Object
+			{
+			protected:
+				static const vint					PriorityCount = 3;
+
+				//A ring buffer that doubles when full, the owner pushes and pops at the back, thieves pop at the front
+				class TaskDeque
+				{
+				protected:
+					collections::Array<Func<void()>>	items;
+					vint							head;
+					vint							count;
+
+				public:
+					TaskDeque();
+
+					vint							Count();
+					void							PushBack(const Func<void()>& proc);
+					Func<void()>					PopBack();
+					Func<void()>					PopFront();
+				};
+
+				struct Worker
+				{
+					vint							index;
+					Thread*							thread;
+					SpinLock						lock;
+					TaskDeque						tasks[PriorityCount];
+					vuint64_t						executedCount;
+					vuint64_t						stealCount;
+					vuint64_t						busyTime;
+				};
+
+				collections::Array<Worker*>			workers;
+				Semaphore							semaphore;
+				SpinLock							startLock;
+				volatile bool						started;
+				volatile bool						stopping;
+				bool								affinity;
+				vint								pendingCount;
+				vint								nextWorker;
+				vuint64_t							startTime;
+
+				static thread_local Worker*			currentWorker;
+				static thread_local PosixThreadPool*	currentPool;
+
+				void								Start();
+				void								Run(Worker* worker);
+				void								TakeTask(Worker* worker, Func<void()>& proc);
+
+			public:
+				//A threadCount of 0 uses one worker for each online processor,
+				//with affinity every worker is pinned to one processor
+				PosixThreadPool(vint threadCount, bool affinity);
+				~PosixThreadPool();
+
+				vint								GetThreadCount();
+				void								Queue(const Func<void()>& proc, PosixTaskPriority priority);
+				PosixThreadPoolStatistics			GetStatistics();
+			};
+		}
+	}
+}
+
+#endif
@@ -20,20 +20,11 @@ namespace vl
 					return listeners.Remove(listener);
 				}
 
-				void XlibNativeCallbackService::SetTimer()
+				void XlibNativeCallbackService::GlobalTimer()
 				{
-					flag = true;
-				}
-
-				void XlibNativeCallbackService::CheckTimer()
-				{
-					if(flag)
+					FOREACH( INativeControllerListener*, i, listeners)
 					{
-						flag = false;
-						FOREACH( INativeControllerListener*, i, listeners)
-						{
-							i->GlobalTimer();
-						}
+						i->GlobalTimer();
 					}
 				}
 				void XlibNativeCallbackService::MouseUpEvent(MouseButton button, Point position)
@@ -43,14 +34,14 @@ namespace vl
 						case MouseButton::LBUTTON:
 							FOREACH( INativeControllerListener*, i, listeners)
 							{
-								i->LeftButtonDown(position);
+								i->LeftButtonUp(position);
 							}
 							break;
 
 						case MouseButton::RBUTTON:
 							FOREACH( INativeControllerListener*, i, listeners)
 							{
-								i->RightButtonDown(position);
+								i->RightButtonUp(position);
 							}
 							break;
 
@@ -66,14 +57,14 @@ namespace vl
 						case MouseButton::LBUTTON:
 							FOREACH( INativeControllerListener*, i, listeners)
 							{
-								i->LeftButtonUp(position);
+								i->LeftButtonDown(position);
 							}
 							break;
 
 						case MouseButton::RBUTTON:
 							FOREACH( INativeControllerListener*, i, listeners)
 							{
-								i->RightButtonUp(position);
+								i->RightButtonDown(position);
 							}
 							break;
 
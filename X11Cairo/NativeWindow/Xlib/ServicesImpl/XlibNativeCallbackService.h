@@ -17,14 +17,12 @@ namespace vl
 				{
 				protected:
 					collections::List<INativeControllerListener*> listeners;
-					bool flag;
 
 				public:
 					virtual bool					InstallListener(INativeControllerListener* listener);
 					virtual bool					UninstallListener(INativeControllerListener* listener);
 
-					void CheckTimer();
-					void SetTimer();
+					void GlobalTimer();
 					void MouseUpEvent(MouseButton button, Point position);
 					void MouseDownEvent(MouseButton button, Point position);
 					void MouseMoveEvent(Point position);
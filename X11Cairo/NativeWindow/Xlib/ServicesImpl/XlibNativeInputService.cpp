@@ -1,3 +1,4 @@
+#include <stdlib.h>
 #include "XlibNativeInputService.h"
 
 namespace vl
@@ -8,43 +9,200 @@ namespace vl
 		{
 			namespace xlib
 			{
+				XlibNativeInputService::XlibNativeInputService(Display* display, PosixAsyncService* asyncService):
+					timerEnabled(false),
+					timerSuspended(false),
+					nextTimerTime(0),
+					timerInterval(1000000 / 60),
+					timerIdleTimeout(3000000),
+					timerDemandTime(0),
+					timerTickCount(0),
+					caretDemand(false),
+					caretDemandTime(0)
+				{
+					if(const char* rate = getenv("GAC_X11_TIMER_RATE"))
+					{
+						SetTimerRate(atoi(rate));
+					}
+					if(const char* idle = getenv("GAC_X11_TIMER_IDLE"))
+					{
+						SetTimerIdleTimeout(atoi(idle));
+					}
+
+					xinput2Helper = new XlibXInput2MouseHookHelper(display);
+					if(xinput2Helper->IsAvailable())
+					{
+						mouseHookHelper = xinput2Helper;
+					}
+					else
+					{
+						delete xinput2Helper;
+						xinput2Helper = NULL;
+
+						//Recorded events are handled by the event loop, which is woken up when they arrive
+						mouseHookHelper = new XlibXRecordMouseHookHelper(XDisplayString(display), [=](){ asyncService->Wakeup(); });
+					}
+				}
+
+				XlibNativeInputService::~XlibNativeInputService()
+				{
+					delete mouseHookHelper;
+				}
+
+				IXlibMouseHookHelper* XlibNativeInputService::GetMouseHookHelper()
+				{
+					return mouseHookHelper;
+				}
+
+				XlibXInput2MouseHookHelper* XlibNativeInputService::GetXInput2MouseHookHelper()
+				{
+					return xinput2Helper;
+				}
+
 				void XlibNativeInputService::StartHookMouse()
 				{
-					//TODO
+					//GacUI hooks the mouse only while a popup is open
+					mouseHookHelper->StartCapture();
 				}
 
 				void XlibNativeInputService::StopHookMouse()
 				{
-					//TODO
-
+					mouseHookHelper->EndCapture();
 				}
 
 				bool XlibNativeInputService::IsHookingMouse()
 				{
-					//TODO
-					return false;
+					return mouseHookHelper->IsCapturing();
 				}
 
 				void XlibNativeInputService::StartTimer()
 				{
-					struct itimerval timer;
-					timer.it_interval.tv_usec = timerInterval;
-					timer.it_interval.tv_sec = 0;
-					timer.it_value.tv_usec = timerInterval;
-					timer.it_value.tv_sec = 0;
-					if(setitimer(ITIMER_REAL, &timer, NULL))
-						throw Exception(L"Failed to setup timer");
+					//The event loop reads nextTimerTime before it blocks, so no wakeup is needed
+					vuint64_t now = GetMonotonicTime();
+					timerEnabled = true;
+					timerSuspended = false;
+					timerDemandTime = now + timerIdleTimeout;
+					nextTimerTime = now + timerInterval;
 				}
 
 				void XlibNativeInputService::StopTimer()
 				{
-					setitimer(ITIMER_REAL, NULL, NULL);
+					timerEnabled = false;
 				}
 
 				bool XlibNativeInputService::IsTimerEnabled()
 				{
-					//TODO
-					return false;
+					return timerEnabled;
+				}
+
+				vuint64_t XlibNativeInputService::GetNextTimerTime()
+				{
+					return timerEnabled && !timerSuspended ? nextTimerTime : 0;
+				}
+
+				bool XlibNativeInputService::CheckTimer(vuint64_t now)
+				{
+					if(!timerEnabled || timerSuspended || now < nextTimerTime) return false;
+					vuint64_t interval = timerInterval;
+					if(timerIdleTimeout > 0 && now >= timerDemandTime)
+					{
+						if(!caretDemand || now >= caretDemandTime)
+						{
+							//An idle application does not wake up until the next input or task,
+							//a pending delay wakes the event loop at its own deadline
+							timerSuspended = true;
+							return false;
+						}
+						if(interval < CaretTimerInterval)
+						{
+							interval = CaretTimerInterval;
+						}
+					}
+
+					nextTimerTime += interval;
+					if(nextTimerTime <= now)
+					{
+						nextTimerTime = now + interval;
+					}
+					timerTickCount++;
+					return true;
+				}
+
+				vint XlibNativeInputService::GetTimerRate()
+				{
+					return (vint)(1000000 / timerInterval);
+				}
+
+				void XlibNativeInputService::SetTimerRate(vint value)
+				{
+					if(value > 0 && value <= 1000)
+					{
+						timerInterval = 1000000 / value;
+					}
+				}
+
+				vint XlibNativeInputService::GetTimerIdleTimeout()
+				{
+					return (vint)(timerIdleTimeout / 1000);
+				}
+
+				void XlibNativeInputService::SetTimerIdleTimeout(vint value)
+				{
+					if(value >= 0)
+					{
+						timerIdleTimeout = (vuint64_t)value * 1000;
+					}
+				}
+
+				void XlibNativeInputService::DemandTimer(vint milliseconds)
+				{
+					vuint64_t now = GetMonotonicTime();
+					vuint64_t demandTime = now + (vuint64_t)milliseconds * 1000;
+					if(demandTime > timerDemandTime)
+					{
+						timerDemandTime = demandTime;
+					}
+					TimerActivity(now);
+				}
+
+				void XlibNativeInputService::TimerActivity(vuint64_t now)
+				{
+					if(now + timerIdleTimeout > timerDemandTime)
+					{
+						timerDemandTime = now + timerIdleTimeout;
+					}
+					caretDemandTime = now + CaretBlinkTimeout;
+					if(timerEnabled && timerSuspended)
+					{
+						timerSuspended = false;
+						nextTimerTime = now;
+					}
+				}
+
+				void XlibNativeInputService::SetCaretDemand(bool value)
+				{
+					//Called on every loop iteration, only a new caret resumes the timer and only before it expires
+					bool resume = value && !caretDemand;
+					caretDemand = value;
+					if(resume && timerEnabled && timerSuspended)
+					{
+						vuint64_t now = GetMonotonicTime();
+						if(now < caretDemandTime)
+						{
+							timerSuspended = false;
+							nextTimerTime = now;
+						}
+					}
+				}
+
+				bool XlibNativeInputService::GetCaretDemand()
+				{
+					return caretDemand;
+				}
+
+				vuint64_t XlibNativeInputService::GetTimerTickCount()
+				{
+					return timerTickCount;
 				}
 
 				bool XlibNativeInputService::IsKeyPressing(vint code)
@@ -2,8 +2,10 @@
 #define __GAC_X11CAIRO_XLIB_NATIVE_INPUT_SERVICE_H
 
 #include <GacUI.h>
-#include <sys/time.h>
 #include "../XlibIncludes.h"
+#include "../XlibXRecordMouseHookHelper.h"
+#include "../XlibXInput2MouseHookHelper.h"
+#include "../../Common/ServicesImpl/PosixAsyncService.h"
 
 namespace vl
 {
@@ -16,10 +18,30 @@ namespace vl
 				class XlibNativeInputService: public Object, public INativeInputService
 				{
 				protected:
+					//XI2 raw events when the server supports them, otherwise XRecord
+					IXlibMouseHookHelper* mouseHookHelper;
+					XlibXInput2MouseHookHelper* xinput2Helper;
 					bool timerEnabled;
-					const int timerInterval = 33333;
+					//The timer is still enabled but stops ticking while nothing demands it
+					bool timerSuspended;
+					vuint64_t nextTimerTime;
+					vuint64_t timerInterval;
+					vuint64_t timerIdleTimeout;
+					vuint64_t timerDemandTime;
+					vuint64_t timerTickCount;
+					bool caretDemand;
+					vuint64_t caretDemandTime;
 
 				public:
+					//Microseconds, half of the blinking interval of the caret in GacUI
+					static const vuint64_t			CaretTimerInterval = 250000;
+					//Microseconds without input or tasks before the caret stops blinking. GacUI does not tell
+					//the native window when a caret closes, so a caret demand never outlives this timeout
+					static const vuint64_t			CaretBlinkTimeout = 10000000;
+
+					XlibNativeInputService(Display* display, PosixAsyncService* asyncService);
+					~XlibNativeInputService();
+
 					virtual void					StartHookMouse();
 					virtual void					StopHookMouse();
 					virtual bool					IsHookingMouse();
@@ -34,7 +56,31 @@ namespace vl
 					virtual WString					GetKeyName(vint code);
 					virtual vint					GetKey(const WString& name);
 
-					static void                     TimerSignalHandler();
+					IXlibMouseHookHelper*			GetMouseHookHelper();
+					//NULL when the global mouse hook uses XRecord
+					XlibXInput2MouseHookHelper*		GetXInput2MouseHookHelper();
+
+					//The monotonic time of the next global timer tick, 0 when the timer is stopped
+					vuint64_t						GetNextTimerTime();
+					//Returns true and schedules the next tick when the tick is due, missed ticks are dropped
+					bool							CheckTimer(vuint64_t now);
+
+					//Ticks per second of the global timer, GAC_X11_TIMER_RATE or 60 by default
+					vint							GetTimerRate();
+					void							SetTimerRate(vint value);
+					//Milliseconds without input or tasks before the timer stops ticking,
+					//GAC_X11_TIMER_IDLE or 3000 by default, 0 keeps the timer always ticking
+					vint							GetTimerIdleTimeout();
+					void							SetTimerIdleTimeout(vint value);
+					//Keeps the timer ticking for at least the given time, for animations not started by input
+					void							DemandTimer(vint milliseconds);
+					//Called by the event loop when something happened, resumes a suspended timer with an immediate tick
+					void							TimerActivity(vuint64_t now);
+					//A visible caret keeps an idle timer ticking, at CaretTimerInterval instead of the full rate,
+					//until CaretBlinkTimeout passes without input or tasks
+					void							SetCaretDemand(bool value);
+					bool							GetCaretDemand();
+					vuint64_t						GetTimerTickCount();
 				};
 			}
 		}
@@ -1,7 +1,15 @@
 #include "XlibNativeWindowService.h"
 #include "../XlibNativeController.h"
+#include "../XlibAtoms.h"
 
 #include <unistd.h>
+#include <limits.h>
+#include <string.h>
+#include <poll.h>
+#include <X11/Xatom.h>
+#ifdef __linux__
+#include <sys/timerfd.h>
+#endif
 
 using namespace vl::presentation;
 using namespace vl::collections;
@@ -14,24 +22,39 @@ namespace vl
 		{
 			namespace xlib
 			{
-				XlibNativeWindowService::XlibNativeWindowService(Display* display, PosixAsyncService* asyncService, XlibNativeCallbackService* callbackService):
+				XlibNativeWindowService::XlibNativeWindowService(Display* display, PosixAsyncService* asyncService, XlibNativeCallbackService* callbackService, XlibNativeInputService* inputService):
 					display(display),
 					asyncService(asyncService),
 					callbackService(callbackService),
-					mainWindow(NULL)
+					inputService(inputService),
+					mainWindow(NULL),
+					timerFd(-1),
+					timerFdDeadline(0),
+					rawMotionCount(0),
+					deliveredMotionCount(0),
+					wakeupCount(0)
 				{
-					recordHelper = new XlibXRecordMouseHookHelper(XDisplayString(display));
+					//_NET_CLIENT_LIST_STACKING changes are reported as PropertyNotify on the root window
+					XSelectInput(display, XDefaultRootWindow(display), PropertyChangeMask);
+#ifdef __linux__
+					timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+#endif
 				}
 
 				XlibNativeWindowService::~XlibNativeWindowService()
 				{
-					delete recordHelper;
+					if(timerFd != -1)
+					{
+						close(timerFd);
+					}
 				}
 
 				INativeWindow *XlibNativeWindowService::CreateNativeWindow()
 				{
 					XlibWindow *window = new XlibWindow(display);
 					windows.Add(window);
+					windowMap.Add(window->GetWindow(), window);
+					stackingOrder.Add(window);
 
 					return window;
 				}
@@ -44,6 +67,9 @@ namespace vl
 						if(actualWindow)
 						{
 							windows.Remove(actualWindow);
+							windowMap.Remove(actualWindow->GetWindow());
+							stackingOrder.Remove(actualWindow);
+							pendingWindows.Remove(actualWindow);
 							delete window;
 						}
 						else
@@ -64,42 +90,81 @@ namespace vl
 
 				INativeWindow* XlibNativeWindowService::GetWindow(Point location)
 				{
-					// Find the top-most window
-					Window seekWindow = XDefaultRootWindow(display);
-					Window resultWindow = seekWindow;
-					int x = 0, y = 0;
-
-					while(true)
+					//Only windows of this process are considered, so a window of another client
+					//covering the point does not hide the one below it
+					for(vint i = stackingOrder.Count() - 1; i >= 0; i--)
 					{
-						if(XTranslateCoordinates(display, XDefaultRootWindow(display), seekWindow,
-							   location.x, location.y, &x, &y, &resultWindow) == XLIB_TRUE)
+						XlibWindow* window = stackingOrder[i];
+						if(window->IsVisible() && window->GetScreenBounds().Contains(location))
 						{
-							if(resultWindow != XLIB_NONE)
-							{
-								seekWindow = resultWindow;
-							}
-							else
-							{
-								return FindWindow(seekWindow);
-							}
+							return window;
 						}
-						else break;
 					}
-
 					return NULL;
 				}
 
 				XlibWindow* XlibNativeWindowService::FindWindow(Window win)
 				{
-					FOREACH(XlibWindow*, i, windows)
+					vint index = windowMap.Keys().IndexOf(win);
+					return index == -1 ? NULL : windowMap.Values().Get(index);
+				}
+
+				void XlibNativeWindowService::RestackWindow(XlibWindow* window, Window above)
+				{
+					vint index = stackingOrder.IndexOf(window);
+					if(index == -1) return;
+
+					if(above == XLIB_NONE)
+					{
+						stackingOrder.RemoveAt(index);
+						stackingOrder.Insert(0, window);
+					}
+					else if(XlibWindow* aboveWindow = FindWindow(above))
+					{
+						stackingOrder.RemoveAt(index);
+						stackingOrder.Insert(stackingOrder.IndexOf(aboveWindow) + 1, window);
+					}
+				}
+
+				void XlibNativeWindowService::UpdateStackingOrder()
+				{
+					Atom type;
+					int format;
+					unsigned long count, remaining;
+					unsigned char* data = NULL;
+					if(XGetWindowProperty(display, XDefaultRootWindow(display), XlibAtoms::_NET_CLIENT_LIST_STACKING,
+							0, LONG_MAX, XLIB_FALSE, XA_WINDOW, &type, &format, &count, &remaining, &data) != XLIB_SUCCESS)
 					{
-						if(i->GetWindow() == win)
+						return;
+					}
+
+					if(data && type == XA_WINDOW && format == 32)
+					{
+						//Managed windows follow the window manager's order, unmanaged ones such as popups stay above them
+						List<XlibWindow*> managedWindows;
+						Window* clients = (Window*)data;
+						for(unsigned long i = 0; i < count; i++)
+						{
+							if(XlibWindow* window = FindWindow(clients[i]))
+							{
+								managedWindows.Add(window);
+							}
+						}
+
+						FOREACH(XlibWindow*, window, managedWindows)
 						{
-							return i;
+							stackingOrder.Remove(window);
+						}
+						for(vint i = managedWindows.Count() - 1; i >= 0; i--)
+						{
+							stackingOrder.Insert(0, managedWindows[i]);
 						}
 					}
 
-					return NULL;
+					if(data)
+					{
+						XFree(data);
+					}
 				}
 
 
@@ -110,8 +175,8 @@ namespace vl
 						result.x = x;
 						result.y = y;
 						result.left = state & Button1Mask;
-						result.right = state & Button2Mask;
-						result.middle = state & Button3Mask;
+						result.right = state & Button3Mask;
+						result.middle = state & Button2Mask;
 						result.ctrl = state & ControlMask;
 						result.shift = state & ShiftMask;
 						result.wheel = 0; // TODO
@@ -121,17 +186,94 @@ namespace vl
 					return result;
 				}
 
-				MouseButton XlibNativeWindowService::XButtonCodeToButton(unsigned int button)
+				vuint64_t XlibNativeWindowService::GetRawMotionCount()
+				{
+					return rawMotionCount;
+				}
+
+				vuint64_t XlibNativeWindowService::GetDeliveredMotionCount()
 				{
-					switch(button)
+					return deliveredMotionCount;
+				}
+
+				vuint64_t XlibNativeWindowService::GetWakeupCount()
+				{
+					return wakeupCount;
+				}
+
+				void XlibNativeWindowService::AddPendingWindow(XlibWindow* window)
+				{
+					if(!pendingWindows.Contains(window))
+					{
+						pendingWindows.Add(window);
+					}
+				}
+
+				void XlibNativeWindowService::WaitForEvents()
+				{
+					//Events read while handling requests are already in the queue and would not wake poll
+					XFlush(display);
+					if(XEventsQueued(display, QueuedAlready) > 0) return;
+
+					vuint64_t now = GetMonotonicTime();
+					vuint64_t deadline = inputService->GetNextTimerTime();
+					//Both deadlines are on CLOCK_MONOTONIC
+					vuint64_t delayTime = asyncService->GetNextDelayTime();
+					if(delayTime != 0 && (deadline == 0 || delayTime < deadline))
+					{
+						deadline = delayTime;
+					}
+
+					int timeout = -1;
+#ifdef __linux__
+					if(timerFd != -1)
+					{
+						if(deadline != timerFdDeadline)
+						{
+							//A zero it_value disarms the timer
+							struct itimerspec spec;
+							memset(&spec, 0, sizeof(spec));
+							spec.it_value.tv_sec = deadline / 1000000;
+							spec.it_value.tv_nsec = (deadline % 1000000) * 1000;
+							timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &spec, NULL);
+							timerFdDeadline = deadline;
+						}
+					}
+					else
+#endif
+					if(deadline != 0)
+					{
+						timeout = deadline <= now ? 0 : (int)((deadline - now + 999) / 1000);
+					}
+
+					struct pollfd fds[3];
+					int count = 0;
+					fds[count].fd = ConnectionNumber(display);
+					fds[count++].events = POLLIN;
+					fds[count].fd = asyncService->GetWakeupHandle();
+					fds[count++].events = POLLIN;
+					if(timerFd != -1)
 					{
-						default:
-						case Button1:
-							return MouseButton::LBUTTON;
-						case Button2:
-							return MouseButton::RBUTTON;
-						case Button3:
-							return MouseButton::MBUTTON;
+						fds[count].fd = timerFd;
+						fds[count++].events = POLLIN;
+					}
+
+					//EINTR only means the loop runs one more time
+					int result = poll(fds, count, timeout);
+					wakeupCount++;
+					if(result > 0)
+					{
+						if(fds[1].revents & POLLIN)
+						{
+							asyncService->ClearWakeup();
+						}
+						if(timerFd != -1 && (fds[2].revents & POLLIN))
+						{
+							vuint64_t expirations;
+							ssize_t size = read(timerFd, &expirations, sizeof(expirations));
+							(void)size;
+							timerFdDeadline = 0;
+						}
 					}
 				}
 
@@ -146,59 +288,79 @@ namespace vl
 					}
 
 					mainWindow->Show();
-					recordHelper->StartCapture();
+					UpdateStackingOrder();
 
 					while(true)
 					{
-	
-						recordHelper->Update();
-
-						recordHelper->ProcessEvents(
-								[this](MouseEvent ev)
-								{
-									switch(ev.type)
-									{
-									case MouseEventType::BUTTONDOWN:
-										callbackService->MouseDownEvent(ev.button, ev.position);
-										break;
-									case MouseEventType::BUTTONUP:
-										callbackService->MouseUpEvent(ev.button, ev.position);
-										break;
-									case MouseEventType::POINTERMOVE:
-										callbackService->MouseMoveEvent(ev.position);
-										break;
-									}
-								});
-								
-
+						//Anything that may start an animation keeps the global timer ticking
+						bool active = false;
 						while(XPending(mainWindow->GetDisplay()))
 						{
 							XlibWindow* evWindow = NULL;
 							XNextEvent(mainWindow->GetDisplay(), &event);
+							//Root property changes come from other clients
+							if(event.type != PropertyNotify)
+							{
+								active = true;
+							}
 							switch(event.type)
 							{
 								case ButtonPress:
 									if((evWindow = FindWindow(event.xbutton.window)) != NULL)
-										evWindow->MouseDownEvent(
-													XButtonCodeToButton(event.xbutton.button),
-													MouseStateMaskToInfo(event.xbutton.x, event.xbutton.y, event.xbutton.state)
-												);
-
+									{
+										evWindow->GetLatencyTracker().InputReceived(LatencyEventType::Button, event.xbutton.time);
+										MouseButton button;
+										if(XButtonCodeToButton(event.xbutton.button, button))
+										{
+											evWindow->MouseDownEvent(
+														button,
+														MouseStateMaskToInfo(event.xbutton.x, event.xbutton.y, event.xbutton.state)
+													);
+										}
+									}
 									break;
 
 								case ButtonRelease:
 									if((evWindow = FindWindow(event.xbutton.window)) != NULL)
-										evWindow->MouseUpEvent(
-													XButtonCodeToButton(event.xbutton.button),
-													MouseStateMaskToInfo(event.xbutton.x, event.xbutton.y, event.xbutton.state)
-												);
+									{
+										MouseButton button;
+										if(XButtonCodeToButton(event.xbutton.button, button))
+										{
+											evWindow->MouseUpEvent(
+														button,
+														MouseStateMaskToInfo(event.xbutton.x, event.xbutton.y, event.xbutton.state)
+													);
+										}
+									}
 									break;
 
 								case MotionNotify:
+									rawMotionCount++;
 									if((evWindow = FindWindow(event.xmotion.window)) != NULL)
+									{
+										evWindow->GetLatencyTracker().InputReceived(LatencyEventType::Motion, event.xmotion.time);
+
+										//Only the latest of the queued moves with the same window and buttons is delivered
+										XEvent nextEvent;
+										while(XEventsQueued(display, QueuedAlready) > 0)
+										{
+											XPeekEvent(display, &nextEvent);
+											if(nextEvent.type != MotionNotify
+												|| nextEvent.xmotion.window != event.xmotion.window
+												|| nextEvent.xmotion.state != event.xmotion.state)
+											{
+												break;
+											}
+											evWindow->AddMotionHistory(Point(event.xmotion.x, event.xmotion.y));
+											XNextEvent(display, &event);
+											rawMotionCount++;
+										}
+
+										deliveredMotionCount++;
 										evWindow->MouseMoveEvent( 
-													MouseStateMaskToInfo(event.xmotion.x, event.xmotion.y, event.xbutton.state)
+													MouseStateMaskToInfo(event.xmotion.x, event.xmotion.y, event.xmotion.state)
 												);
+									}
 									break;
 
 								case EnterNotify:
@@ -208,7 +370,14 @@ namespace vl
 
 								case LeaveNotify:
 									if((evWindow = FindWindow(event.xcrossing.window)) != NULL)
-										evWindow->MouseEnterEvent();
+										evWindow->MouseLeaveEvent();
+									break;
+
+								case GenericEvent:
+									if(XlibXInput2MouseHookHelper* xinput2Helper = inputService->GetXInput2MouseHookHelper())
+									{
+										xinput2Helper->HandleEvent(event);
+									}
 									break;
 
 								case ClientMessage:
@@ -217,13 +386,61 @@ namespace vl
 
 								case ConfigureNotify:
 									if((evWindow = FindWindow(event.xconfigure.window)) != NULL)
-										evWindow->ResizeEvent(event.xconfigure.width, event.xconfigure.height);
+									{
+										//Siblings of a framed window are the other children of its frame
+										if(!event.xconfigure.send_event && !evWindow->IsReparented())
+										{
+											RestackWindow(evWindow, event.xconfigure.above);
+										}
+										evWindow->ConfigureEvent(event.xconfigure);
+										AddPendingWindow(evWindow);
+									}
+									break;
+
+								case MapNotify:
+									//A newly mapped window is on the top until the stacking order says otherwise
+									if((evWindow = FindWindow(event.xmap.window)) != NULL)
+									{
+										stackingOrder.Remove(evWindow);
+										stackingOrder.Add(evWindow);
+									}
+									break;
+
+								case ReparentNotify:
+									if((evWindow = FindWindow(event.xreparent.window)) != NULL)
+									{
+										evWindow->ReparentEvent(event.xreparent.parent);
+									}
+									break;
+
+								case PropertyNotify:
+									if(event.xproperty.window == XDefaultRootWindow(display) && event.xproperty.atom == XlibAtoms::_NET_CLIENT_LIST_STACKING)
+									{
+										UpdateStackingOrder();
+									}
 									break;
 
 								case Expose:
 								case GraphicsExpose:
+									//A series of exposed rectangles ends with count == 0
 									if((evWindow = FindWindow(event.xexpose.window)) != NULL)
-										evWindow->RedrawContent();
+									{
+										evWindow->ExposeEvent(Rect(Point(event.xexpose.x, event.xexpose.y), Size(event.xexpose.width, event.xexpose.height)));
+										if(event.xexpose.count == 0)
+										{
+											AddPendingWindow(evWindow);
+										}
+									}
+									break;
+
+								case FocusIn:
+								case FocusOut:
+									//Focusing a window counts as input, the caret starts blinking again
+									if((evWindow = FindWindow(event.xfocus.window)) != NULL)
+									{
+										evWindow->FocusEvent(event.xfocus);
+										active = true;
+									}
 									break;
 
 								case VisibilityNotify:
@@ -241,16 +458,73 @@ namespace vl
 							}
 						}
 
-						asyncService->ExecuteAsyncTasks();
-						callbackService->CheckTimer();
-					
-						XFlush(mainWindow->GetDisplay());
+						//Global mouse events are dispatched after the events of the windows read in the same pass
+						inputService->GetMouseHookHelper()->ProcessEvents(
+								[this, &active](MouseEvent ev)
+								{
+									active = true;
+									switch(ev.type)
+									{
+									case MouseEventType::BUTTONDOWN:
+										callbackService->MouseDownEvent(ev.button, ev.position);
+										break;
+									case MouseEventType::BUTTONUP:
+										callbackService->MouseUpEvent(ev.button, ev.position);
+										break;
+									case MouseEventType::POINTERMOVE:
+										callbackService->MouseMoveEvent(ev.position);
+										break;
+									}
+								});
+
+						while(pendingWindows.Count() > 0)
+						{
+							XlibWindow* pendingWindow = pendingWindows[0];
+							pendingWindows.RemoveAt(0);
+							pendingWindow->FlushPendingEvents();
+						}
+
+						if(asyncService->ExecuteAsyncTasks())
+						{
+							active = true;
+						}
+
+						vuint64_t now = GetMonotonicTime();
+						if(active)
+						{
+							inputService->TimerActivity(now);
+						}
+						bool caret = false;
+						FOREACH(XlibWindow*, i, windows)
+						{
+							if(i->HasCaret())
+							{
+								caret = true;
+								break;
+							}
+						}
+						inputService->SetCaretDemand(caret);
+						if(inputService->CheckTimer(now))
+						{
+							callbackService->GlobalTimer();
+							//GacUI renders inside the tick, input that did not start a frame caused no repaint
+							FOREACH(XlibWindow*, i, windows)
+							{
+								i->GetLatencyTracker().DropUnrenderedInput();
+							}
+						}
+
+						//Property changes made by this iteration go out together with the XFlush before waiting
+						FOREACH(XlibWindow*, i, windows)
+						{
+							i->FlushPendingUpdates();
+						}
 
-						pause();
+						WaitForEvents();
 					}
 
 Cleanup:
-					recordHelper->EndCapture();
+					inputService->StopHookMouse();
 					XFlush(mainWindow->GetDisplay());
 
 					mainWindow = NULL;
@@ -4,9 +4,9 @@
 #include <GacUI.h>
 #include "../XlibIncludes.h"
 #include "../XlibWindow.h"
-#include "../XlibXRecordMouseHookHelper.h"
 #include "../../Common/ServicesImpl/PosixAsyncService.h"
 #include "XlibNativeCallbackService.h"
+#include "XlibNativeInputService.h"
 
 namespace vl
 {
@@ -22,18 +22,34 @@ namespace vl
 					Display* display;
 					PosixAsyncService* asyncService;
 					XlibNativeCallbackService* callbackService;
-					XlibXRecordMouseHookHelper* recordHelper;
+					XlibNativeInputService* inputService;
 					XlibWindow* mainWindow;
 					vl::collections::List<XlibWindow*> windows;
-					bool timerFlag;
+					vl::collections::Dictionary<Window, XlibWindow*> windowMap;
+					//Visible or not, from the bottom to the top
+					vl::collections::List<XlibWindow*> stackingOrder;
+					//Windows with exposed areas or a new size, painted after the event queue is drained
+					vl::collections::List<XlibWindow*> pendingWindows;
+
+					//A timerfd armed for the next global timer tick or delay, -1 when poll timeouts are used instead
+					int timerFd;
+					vuint64_t timerFdDeadline;
+
+					vuint64_t rawMotionCount;
+					vuint64_t deliveredMotionCount;
+					vuint64_t wakeupCount;
+
+					void WaitForEvents();
+					void AddPendingWindow(XlibWindow* window);
+					void RestackWindow(XlibWindow* window, Window above);
+					void UpdateStackingOrder();
 
 					XlibWindow* FindWindow(Window win);
 					void DispatchGlobalMouseEvent(const MouseEvent& ev);
 					NativeWindowMouseInfo MouseStateMaskToInfo(int x, int y, unsigned int state);
-					MouseButton XButtonCodeToButton(unsigned int button);
 
 				public:
-					XlibNativeWindowService (Display* display, PosixAsyncService* asyncService, XlibNativeCallbackService* callbackService);
+					XlibNativeWindowService (Display* display, PosixAsyncService* asyncService, XlibNativeCallbackService* callbackService, XlibNativeInputService* inputService);
 
 					virtual ~XlibNativeWindowService ();
 
@@ -46,6 +62,12 @@ namespace vl
 					virtual INativeWindow *GetWindow (Point location);
 
 					virtual void Run (INativeWindow *window);
+
+					//MotionNotify events read from the server, and MouseMoving calls left after merging them
+					vuint64_t GetRawMotionCount();
+					vuint64_t GetDeliveredMotionCount();
+					//Times the event loop returned from waiting, an idle application should not wake up at all
+					vuint64_t GetWakeupCount();
 				};
             }
         }
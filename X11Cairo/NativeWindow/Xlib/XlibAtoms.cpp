@@ -22,6 +22,7 @@ namespace vl
 				DEFINE_ATOM(_NET_WM_WINDOW_TYPE);
 				DEFINE_ATOM(_NET_WM_WINDOW_TYPE_NORMAL);
 				DEFINE_ATOM(_NET_WM_WINDOW_TYPE_POPUP_MENU);
+				DEFINE_ATOM(_NET_CLIENT_LIST_STACKING);
 
 				void XlibAtoms::Initialize(Display* display)
 				{
@@ -33,6 +34,7 @@ namespace vl
 						INIT_ATOM(_NET_WM_WINDOW_TYPE);
 						INIT_ATOM(_NET_WM_WINDOW_TYPE_NORMAL);
 						INIT_ATOM(_NET_WM_WINDOW_TYPE_POPUP_MENU);
+						INIT_ATOM(_NET_CLIENT_LIST_STACKING);
 
 						initialized = true;
 					}
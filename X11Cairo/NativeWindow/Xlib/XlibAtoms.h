@@ -20,6 +20,7 @@ namespace vl
 					static Atom _NET_WM_WINDOW_TYPE;
 					static Atom _NET_WM_WINDOW_TYPE_NORMAL;
 					static Atom _NET_WM_WINDOW_TYPE_POPUP_MENU;
+					static Atom _NET_CLIENT_LIST_STACKING;
 
 					static void Initialize(Display* display);
 				};
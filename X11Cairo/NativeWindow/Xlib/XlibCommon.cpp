@@ -31,6 +31,24 @@ namespace vl
 					}
 					return false;
 				}
+
+				bool XButtonCodeToButton(unsigned int code, MouseButton& button)
+				{
+					switch(code)
+					{
+						case Button1:
+							button = MouseButton::LBUTTON;
+							return true;
+						case Button2:
+							button = MouseButton::MBUTTON;
+							return true;
+						case Button3:
+							button = MouseButton::RBUTTON;
+							return true;
+						default:
+							return false;
+					}
+				}
 			}
 		}
 	}
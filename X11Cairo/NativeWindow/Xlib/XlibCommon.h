@@ -3,6 +3,7 @@
 
 #include <GacUI.h>
 #include "XlibIncludes.h"
+#include "../Common/MonotonicTime.h"
 
 namespace vl
 {
@@ -42,6 +43,19 @@ namespace vl
 					}
 				};
 
+				//A global mouse hook, events are collected while capturing and dispatched by ProcessEvents on the main thread
+				class IXlibMouseHookHelper: public Interface
+				{
+				public:
+					virtual void ProcessEvents(const Func<void(MouseEvent)>& handler) = 0;
+					virtual void StartCapture() = 0;
+					virtual void EndCapture() = 0;
+					virtual bool IsCapturing() = 0;
+				};
+
+				//Maps the core protocol button numbers, returns false for wheel and extra buttons
+				bool XButtonCodeToButton(unsigned int code, MouseButton& button);
+
 				struct MotifWmHints
 				{
 					long flags;
@@ -0,0 +1,306 @@
+#include <limits.h>
+#include <cairo/cairo-xlib-xrender.h>
+
+#include "XlibImageUploader.h"
+
+using namespace vl::collections;
+
+namespace vl
+{
+	namespace presentation
+	{
+		namespace x11cairo
+		{
+			namespace xlib
+			{
+/***********************************************************************
+XlibImageFrameCache
+***********************************************************************/
+
+				XlibImageFrameCache::XlibImageFrameCache(XlibImageUploader* _uploader):
+					uploader(_uploader)
+				{
+					uploader->caches.Add(this);
+				}
+
+				XlibImageFrameCache::~XlibImageFrameCache()
+				{
+					if(uploader)
+					{
+						FOREACH(Ptr<XlibImageUpload>, upload, uploads)
+						{
+							uploader->Release(upload.Obj());
+						}
+						uploader->caches.Remove(this);
+					}
+				}
+
+				void XlibImageFrameCache::UploaderDestroyed()
+				{
+					FOREACH(Ptr<XlibImageUpload>, upload, uploads)
+					{
+						if(upload->surface)
+						{
+							cairo_surface_finish(upload->surface);
+							cairo_surface_destroy(upload->surface);
+							upload->surface = NULL;
+						}
+						upload->pixmap = XLIB_NONE;
+						upload->cache = NULL;
+					}
+					uploads.Clear();
+					uploader = NULL;
+				}
+
+				void XlibImageFrameCache::OnAttach(INativeImageFrame* frame)
+				{
+				}
+
+				void XlibImageFrameCache::OnDetach(INativeImageFrame* frame)
+				{
+					if(!uploader) return;
+					FOREACH(Ptr<XlibImageUpload>, upload, uploads)
+					{
+						uploader->Release(upload.Obj());
+					}
+					uploads.Clear();
+				}
+
+				bool XlibImageFrameCache::Contains(Size size)
+				{
+					FOREACH(Ptr<XlibImageUpload>, upload, uploads)
+					{
+						if(upload->size == size) return true;
+					}
+					return false;
+				}
+
+				cairo_surface_t* XlibImageFrameCache::GetSurface(Size size)
+				{
+					FOREACH(Ptr<XlibImageUpload>, upload, uploads)
+					{
+						if(upload->size == size) return upload->surface;
+					}
+					return NULL;
+				}
+
+				void XlibImageFrameCache::Add(Ptr<XlibImageUpload> upload)
+				{
+					if(!uploader) return;
+					uploads.Insert(0, upload);
+					if(uploads.Count() > MaxUploadCount)
+					{
+						uploader->Release(uploads[uploads.Count() - 1].Obj());
+						uploads.RemoveAt(uploads.Count() - 1);
+					}
+				}
+
+/***********************************************************************
+XlibImageUploader
+***********************************************************************/
+
+				void XlibImageUploader::Run()
+				{
+					uploadDisplay = XOpenDisplay(DisplayString(mainDisplay));
+
+					while(!stopping)
+					{
+						semaphore.Wait();
+
+						Ptr<XlibImageUpload> upload;
+						SPIN_LOCK(lock)
+						{
+							if(!stopping && pendingUploads.Count() > 0)
+							{
+								upload = pendingUploads[0];
+								pendingUploads.RemoveAt(0);
+							}
+						}
+
+						if(upload)
+						{
+							UploadImage(upload.Obj());
+							GetCurrentController()->AsyncService()->InvokeInMainThread([=]()
+							{
+								UploadFinished(upload);
+							});
+						}
+					}
+				}
+
+				void XlibImageUploader::UploadImage(XlibImageUpload* upload)
+				{
+					if(uploadDisplay)
+					{
+						int screen = DefaultScreen(uploadDisplay);
+						upload->depth = cairo_image_surface_get_format(upload->image) == CAIRO_FORMAT_ARGB32 ? 32 : 24;
+						upload->pixmap = XCreatePixmap(uploadDisplay, RootWindow(uploadDisplay, screen), upload->size.x, upload->size.y, upload->depth);
+
+						//Cairo image surfaces hold native endian 32 bit pixels
+						XImage* image = XCreateImage(
+								uploadDisplay,
+								DefaultVisual(uploadDisplay, screen),
+								upload->depth,
+								ZPixmap,
+								0,
+								(char*)cairo_image_surface_get_data(upload->image),
+								upload->size.x,
+								upload->size.y,
+								32,
+								cairo_image_surface_get_stride(upload->image)
+								);
+						int endian = 1;
+						image->byte_order = *(char*)&endian ? LSBFirst : MSBFirst;
+
+						GC gc = XCreateGC(uploadDisplay, upload->pixmap, 0, NULL);
+						XPutImage(uploadDisplay, upload->pixmap, gc, image, 0, 0, 0, 0, upload->size.x, upload->size.y);
+						XFreeGC(uploadDisplay, gc);
+
+						image->data = NULL;
+						XDestroyImage(image);
+
+						//The pixmap must exist on the server before the main connection refers to it
+						XSync(uploadDisplay, XLIB_FALSE);
+					}
+
+					cairo_surface_destroy(upload->image);
+					upload->image = NULL;
+				}
+
+				XlibImageUploader::XlibImageUploader(Display* display):
+					mainDisplay(display),
+					uploadDisplay(NULL),
+					thread(NULL),
+					stopping(false)
+				{
+					semaphore.Create(0, INT_MAX);
+				}
+
+				XlibImageUploader::~XlibImageUploader()
+				{
+					if(thread)
+					{
+						stopping = true;
+						semaphore.Release();
+						thread->Wait();
+						delete thread;
+						thread = NULL;
+					}
+
+					FOREACH(Ptr<XlibImageUpload>, upload, pendingUploads)
+					{
+						cairo_surface_destroy(upload->image);
+					}
+					pendingUploads.Clear();
+
+					//Closing the upload connection frees every pixmap it created, the main connection must be done with them first
+					while(caches.Count() > 0)
+					{
+						XlibImageFrameCache* cache = caches[caches.Count() - 1];
+						caches.RemoveAt(caches.Count() - 1);
+						cache->UploaderDestroyed();
+					}
+					XSync(mainDisplay, XLIB_FALSE);
+					if(uploadDisplay)
+					{
+						XCloseDisplay(uploadDisplay);
+						uploadDisplay = NULL;
+					}
+				}
+
+				cairo_surface_t* XlibImageUploader::GetSurface(INativeImageFrame* frame, Size size)
+				{
+					Ptr<INativeImageFrameCache> cache = frame->GetCache(this);
+					XlibImageFrameCache* frameCache = dynamic_cast<XlibImageFrameCache*>(cache.Obj());
+					return frameCache ? frameCache->GetSurface(size) : NULL;
+				}
+
+				void XlibImageUploader::Upload(INativeImageFrame* frame, cairo_surface_t* image)
+				{
+					cairo_format_t format = cairo_image_surface_get_format(image);
+					if(format != CAIRO_FORMAT_ARGB32 && format != CAIRO_FORMAT_RGB24) return;
+
+					Size size(cairo_image_surface_get_width(image), cairo_image_surface_get_height(image));
+					Ptr<XlibImageFrameCache> frameCache = frame->GetCache(this).Cast<XlibImageFrameCache>();
+					if(!frameCache)
+					{
+						frameCache = new XlibImageFrameCache(this);
+						frame->SetCache(this, frameCache);
+					}
+					if(frameCache->Contains(size)) return;
+
+					Ptr<XlibImageUpload> upload = new XlibImageUpload;
+					upload->image = cairo_surface_reference(image);
+					upload->size = size;
+					upload->depth = 0;
+					upload->pixmap = XLIB_NONE;
+					upload->surface = NULL;
+					upload->cache = frameCache.Obj();
+					frameCache->Add(upload);
+
+					SPIN_LOCK(lock)
+					{
+						pendingUploads.Add(upload);
+					}
+
+					if(!thread)
+					{
+						thread = Thread::CreateAndStart([this](){ Run(); }, false);
+					}
+					semaphore.Release();
+				}
+
+				void XlibImageUploader::UploadFinished(Ptr<XlibImageUpload> upload)
+				{
+					if(upload->pixmap == XLIB_NONE) return;
+
+					if(upload->cache)
+					{
+						XRenderPictFormat* format = XRenderFindStandardFormat(mainDisplay, upload->depth == 32 ? PictStandardARGB32 : PictStandardRGB24);
+						upload->surface = cairo_xlib_surface_create_with_xrender_format(
+								mainDisplay,
+								upload->pixmap,
+								DefaultScreenOfDisplay(mainDisplay),
+								format,
+								upload->size.x,
+								upload->size.y
+								);
+					}
+					else
+					{
+						//The frame went away while its pixels were being uploaded
+						XFreePixmap(mainDisplay, upload->pixmap);
+						upload->pixmap = XLIB_NONE;
+					}
+				}
+
+				void XlibImageUploader::Release(XlibImageUpload* upload)
+				{
+					//Any client may free the pixmaps of the upload connection while it is open.
+					//Unfinished uploads free their pixmap in UploadFinished
+					if(upload->surface)
+					{
+						cairo_surface_finish(upload->surface);
+						cairo_surface_destroy(upload->surface);
+						upload->surface = NULL;
+						XFreePixmap(mainDisplay, upload->pixmap);
+						upload->pixmap = XLIB_NONE;
+					}
+					upload->cache = NULL;
+				}
+
+				XlibImageUploader* xlibImageUploader = NULL;
+
+				XlibImageUploader* GetXlibImageUploader()
+				{
+					return xlibImageUploader;
+				}
+
+				void SetXlibImageUploader(XlibImageUploader* uploader)
+				{
+					xlibImageUploader = uploader;
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,89 @@
+#ifndef __GAC_X11CAIRO_XLIB_IMAGE_UPLOADER_H
+#define __GAC_X11CAIRO_XLIB_IMAGE_UPLOADER_H
+
+#include <GacUI.h>
+#include "../../GraphicsElement/CairoPangoIncludes.h"
+#include "XlibIncludes.h"
+
+namespace vl
+{
+	namespace presentation
+	{
+		namespace x11cairo
+		{
+			namespace xlib
+			{
+				class XlibImageUploader;
+				class XlibImageFrameCache;
+
+				struct XlibImageUpload
+				{
+					cairo_surface_t*					image;
+					Size								size;
+					int									depth;
+					Pixmap								pixmap;
+					cairo_surface_t*					surface;
+					XlibImageFrameCache*				cache;
+				};
+
+				//Server side copies of one image frame, one for each uploaded size
+				class XlibImageFrameCache: public Object, public INativeImageFrameCache
+				{
+				protected:
+					XlibImageUploader*								uploader;
+					collections::List<Ptr<XlibImageUpload>>			uploads;
+
+				public:
+					static const vint								MaxUploadCount = 5;
+
+					XlibImageFrameCache(XlibImageUploader* _uploader);
+					~XlibImageFrameCache();
+
+					//Called when the uploader goes away before the frame, the pixmaps die with the upload connection
+					void								UploaderDestroyed();
+
+					void								OnAttach(INativeImageFrame* frame)override;
+					void								OnDetach(INativeImageFrame* frame)override;
+
+					bool								Contains(Size size);
+					cairo_surface_t*					GetSurface(Size size);
+					void								Add(Ptr<XlibImageUpload> upload);
+				};
+
+				//Uploads decoded images into pixmaps over a second connection, so that large uploads
+				//never block the event loop, and every later paint only sends a composite request.
+				//The pixmaps belong to the upload connection, so it stays open until the uploader is destroyed
+				class XlibImageUploader: public Object
+				{
+					friend class XlibImageFrameCache;
+				protected:
+					Display*							mainDisplay;
+					Display*							uploadDisplay;
+					Thread*								thread;
+					Semaphore							semaphore;
+					SpinLock							lock;
+					collections::List<Ptr<XlibImageUpload>>	pendingUploads;
+					collections::List<XlibImageFrameCache*>	caches;
+					volatile bool						stopping;
+
+					void								Run();
+					void								UploadImage(XlibImageUpload* upload);
+
+				public:
+					XlibImageUploader(Display* display);
+					~XlibImageUploader();
+
+					cairo_surface_t*					GetSurface(INativeImageFrame* frame, Size size);
+					void								Upload(INativeImageFrame* frame, cairo_surface_t* image);
+					void								UploadFinished(Ptr<XlibImageUpload> upload);
+					void								Release(XlibImageUpload* upload);
+				};
+
+				extern XlibImageUploader* GetXlibImageUploader();
+				extern void SetXlibImageUploader(XlibImageUploader* uploader);
+			}
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,179 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "XlibLatencyTracker.h"
+
+namespace vl
+{
+	namespace presentation
+	{
+		namespace x11cairo
+		{
+			namespace xlib
+			{
+/***********************************************************************
+Server Clock
+***********************************************************************/
+
+				//The smallest local time minus server time seen so far, the server clock plus this offset
+				//is an estimation of when the event happened, expressed in local monotonic milliseconds
+				static bool serverClockKnown = false;
+				static vint64_t serverClockOffset = 0;
+
+				static vuint64_t ServerTimeToLocalTime(Time serverTime, vuint64_t now)
+				{
+					vint64_t offset = (vint64_t)(now / 1000) - (vint64_t)serverTime;
+
+					//A big jump means the 32 bit server time wrapped or the server restarted
+					if(!serverClockKnown || offset < serverClockOffset || offset > serverClockOffset + 10000)
+					{
+						serverClockKnown = true;
+						serverClockOffset = offset;
+					}
+					return ((vint64_t)serverTime + serverClockOffset) * 1000;
+				}
+
+				static bool IsTraceEnabled()
+				{
+					static int enabled = -1;
+					if(enabled == -1)
+					{
+						const char* value = getenv("GAC_X11_LATENCY_TRACE");
+						enabled = value && *value && *value != '0' ? 1 : 0;
+					}
+					return enabled == 1;
+				}
+
+				static const char* GetEventTypeName(LatencyEventType type)
+				{
+					switch(type)
+					{
+						case LatencyEventType::Button:
+							return "button";
+						case LatencyEventType::Key:
+							return "key";
+						case LatencyEventType::Motion:
+							return "motion";
+					}
+					return "";
+				}
+
+/***********************************************************************
+LatencyHistogram
+***********************************************************************/
+
+				LatencyHistogram::LatencyHistogram():
+					count(0),
+					maximum(0),
+					total(0)
+				{
+					for(vint i = 0; i < BucketCount; i++)
+					{
+						buckets[i] = 0;
+					}
+				}
+
+				void LatencyHistogram::Add(vint milliseconds)
+				{
+					vint bucket = 0;
+					while(bucket < BucketCount - 1 && milliseconds >= ((vint)1 << bucket))
+					{
+						bucket++;
+					}
+					buckets[bucket]++;
+					count++;
+					total += milliseconds;
+					if(milliseconds > maximum) maximum = milliseconds;
+				}
+
+				vint LatencyHistogram::GetAverage()const
+				{
+					return count == 0 ? 0 : (vint)(total / count);
+				}
+
+/***********************************************************************
+XlibLatencyTracker
+***********************************************************************/
+
+				XlibLatencyTracker::XlibLatencyTracker()
+				{
+					for(vint i = 0; i < EventTypeCount; i++)
+					{
+						pendingTimes[i] = 0;
+						renderingTimes[i] = 0;
+					}
+				}
+
+				void XlibLatencyTracker::InputReceived(LatencyEventType type, Time serverTime)
+				{
+					vuint64_t eventTime = ServerTimeToLocalTime(serverTime, GetMonotonicTime());
+					vuint64_t& pending = pendingTimes[(vint)type];
+					if(pending == 0 || eventTime < pending)
+					{
+						pending = eventTime;
+					}
+				}
+
+				void XlibLatencyTracker::FrameStarted()
+				{
+					for(vint i = 0; i < EventTypeCount; i++)
+					{
+						if(pendingTimes[i] == 0) continue;
+						if(renderingTimes[i] == 0 || pendingTimes[i] < renderingTimes[i])
+						{
+							renderingTimes[i] = pendingTimes[i];
+						}
+						pendingTimes[i] = 0;
+					}
+				}
+
+				void XlibLatencyTracker::DropUnrenderedInput()
+				{
+					for(vint i = 0; i < EventTypeCount; i++)
+					{
+						pendingTimes[i] = 0;
+					}
+				}
+
+				bool XlibLatencyTracker::HasPendingInput()
+				{
+					for(vint i = 0; i < EventTypeCount; i++)
+					{
+						if(renderingTimes[i] != 0) return true;
+					}
+					return false;
+				}
+
+				void XlibLatencyTracker::FramePresented(Window window)
+				{
+					vuint64_t now = GetMonotonicTime();
+					for(vint i = 0; i < EventTypeCount; i++)
+					{
+						if(renderingTimes[i] == 0) continue;
+
+						vint milliseconds = now > renderingTimes[i] ? (vint)((now - renderingTimes[i]) / 1000) : 0;
+						renderingTimes[i] = 0;
+						LatencyHistogram& histogram = histograms[i];
+						histogram.Add(milliseconds);
+
+						if(IsTraceEnabled())
+						{
+							fprintf(stderr, "[latency] window=0x%lx type=%s latency=%dms count=%d average=%dms max=%dms\n",
+								(unsigned long)window,
+								GetEventTypeName((LatencyEventType)i),
+								(int)milliseconds,
+								(int)histogram.count,
+								(int)histogram.GetAverage(),
+								(int)histogram.maximum
+								);
+						}
+					}
+				}
+
+				const LatencyHistogram& XlibLatencyTracker::GetHistogram(LatencyEventType type)
+				{
+					return histograms[(vint)type];
+				}
+			}
+		}
+	}
+}
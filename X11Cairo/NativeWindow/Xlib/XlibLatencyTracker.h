@@ -0,0 +1,70 @@
+#ifndef __GAC_X11CAIRO_XLIB_LATENCY_TRACKER_H
+#define __GAC_X11CAIRO_XLIB_LATENCY_TRACKER_H
+
+#include <GacUI.h>
+#include "XlibIncludes.h"
+
+namespace vl
+{
+	namespace presentation
+	{
+		namespace x11cairo
+		{
+			namespace xlib
+			{
+				enum class LatencyEventType
+				{
+					Button,
+					//Not recorded until the backend dispatches key events
+					Key,
+					Motion,
+				};
+
+				//Bucket 0 counts samples below 1ms, bucket i counts samples in [2^(i-1), 2^i) ms, the last one is open ended
+				struct LatencyHistogram
+				{
+					static const vint				BucketCount = 12;
+
+					vint							buckets[BucketCount];
+					vint							count;
+					vint							maximum;
+					vuint64_t						total;
+
+					LatencyHistogram();
+
+					void							Add(vint milliseconds);
+					vint							GetAverage()const;
+				};
+
+				//Measures the time from the X server timestamp of an input event to the frame of the same window
+				//that is sent to the server after it. Input that no frame started rendering for by the end of the
+				//next global timer tick did not cause a repaint, and is dropped instead of charged to a later frame
+				class XlibLatencyTracker
+				{
+				protected:
+					static const vint				EventTypeCount = 3;
+
+					LatencyHistogram				histograms[EventTypeCount];
+					//Monotonic microseconds of the oldest input, 0 when there is none.
+					//Input is pending until a frame starts rendering, then rendering until the frame is presented
+					vuint64_t						pendingTimes[EventTypeCount];
+					vuint64_t						renderingTimes[EventTypeCount];
+
+				public:
+					XlibLatencyTracker();
+
+					void							InputReceived(LatencyEventType type, Time serverTime);
+					void							FrameStarted();
+					//Called by the event loop after every global timer tick
+					void							DropUnrenderedInput();
+					//True when a frame being rendered has input to report once it is presented
+					bool							HasPendingInput();
+					void							FramePresented(Window window);
+					const LatencyHistogram&			GetHistogram(LatencyEventType type);
+				};
+			}
+		}
+	}
+}
+
+#endif
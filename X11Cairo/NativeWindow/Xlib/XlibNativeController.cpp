@@ -1,13 +1,13 @@
-#include <signal.h>
-
 #include "XlibAtoms.h"
 #include "XlibNativeController.h"
+#include "XlibImageUploader.h"
 #include "ServicesImpl/XlibNativeWindowService.h"
 #include "ServicesImpl/XlibNativeScreenService.h"
 #include "ServicesImpl/XlibNativeResourceService.h"
 #include "ServicesImpl/XlibNativeInputService.h"
 #include "ServicesImpl/XlibNativeCallbackService.h"
 #include "../Common/ServicesImpl/PosixAsyncService.h"
+#include "../Common/ServicesImpl/CairoImageService.h"
 
 #include "XlibIncludes.h"
 
@@ -32,15 +32,19 @@ namespace vl
 					XlibNativeResourceService *resourceService;
 					PosixAsyncService *asyncService;
 					INativeClipboardService *clipboardService;
-					INativeImageService *imageService;
+					CairoImageService *imageService;
 					XlibNativeScreenService *screenService;
 					XlibNativeWindowService *windowService;
 					XlibNativeInputService *inputService;
 					INativeDialogService *dialogService;
 
+					XlibImageUploader *imageUploader;
+
 				public:
 					XlibNativeController(const char *displayString = NULL)
 					{
+						//The image uploader and the mouse hook use their own connections on worker threads
+						XInitThreads();
 						XSetErrorHandler(NULL);
 						display = XOpenDisplay(displayString);
 						if(!display)
@@ -50,21 +54,22 @@ namespace vl
 
 						asyncService = new PosixAsyncService();
 						screenService = new XlibNativeScreenService(display);
-						inputService = new XlibNativeInputService();
+						inputService = new XlibNativeInputService(display, asyncService);
 						callbackService = new XlibNativeCallbackService();
-						windowService = new XlibNativeWindowService(display, asyncService, callbackService);
+						windowService = new XlibNativeWindowService(display, asyncService, callbackService, inputService);
 						resourceService = new XlibNativeResourceService();
+						imageService = new CairoImageService();
+						imageUploader = new XlibImageUploader(display);
+						SetXlibImageUploader(imageUploader);
 
 						XlibAtoms::Initialize(display);
-
-						if(signal(SIGALRM, XlibNativeController::TimerSignalHandler))
-						{
-							throw Exception(L"Unable to set signal handler");
-						}
 					}
 
 					virtual ~XlibNativeController()
 					{
+						SetXlibImageUploader(NULL);
+						delete imageUploader;
+						delete imageService;
 						delete resourceService;
 						delete windowService;
 						delete callbackService;
@@ -98,8 +103,7 @@ namespace vl
 
 					virtual INativeImageService *ImageService()
 					{
-						//TODO
-						return NULL;
+						return imageService;
 					}
 
 					virtual INativeScreenService *ScreenService()
@@ -133,18 +137,6 @@ namespace vl
 						//TODO
 						return WString();
 					}
-
-					static void TimerSignalHandler(int signal)
-					{
-						if(XlibNativeController* controller = dynamic_cast<XlibNativeController*>(GetCurrentController()))
-						{
-							XlibNativeCallbackService* callbackService = dynamic_cast<XlibNativeCallbackService*>(controller->CallbackService());
-							if(callbackService)
-							{
-								callbackService->SetTimer();
-							}
-						}
-					}
 				};
 
 				vl::presentation::INativeController *CreateXlibCairoNativeController(const char *displayname)
@@ -1,4 +1,6 @@
 #include <limits.h>
+#include <string.h>
+#include <X11/Xatom.h>
 #include "XlibAtoms.h"
 #include "XlibWindow.h"
 
@@ -23,7 +25,15 @@ namespace vl
 					backBuffer(XLIB_NONE),
 					parentWindow(NULL),
 					bounds(0, 0, 400, 200),
-					clientSize(400, 200)
+					clientSize(400, 200),
+					motionHistoryEnabled(false),
+					caretVisible(false),
+					inputFocus(true),
+					configurePending(false),
+					movePending(false),
+					configuredSize(400, 200),
+					reparented(false),
+					pendingUpdates(PendingTitle)
 				{
 					this->display = display;
 					window = XCreateWindow(
@@ -42,13 +52,10 @@ namespace vl
 							);
 
 
-					XSelectInput(display, window, PointerMotionMask | ButtonPressMask | ButtonReleaseMask | KeyPressMask | KeyReleaseMask | StructureNotifyMask | SubstructureNotifyMask | VisibilityChangeMask | ExposureMask);
+					XSelectInput(display, window, PointerMotionMask | ButtonPressMask | ButtonReleaseMask | KeyPressMask | KeyReleaseMask | StructureNotifyMask | SubstructureNotifyMask | VisibilityChangeMask | ExposureMask | FocusChangeMask);
 					XSetWMProtocols(display, window, &XlibAtoms::WM_DELETE_WINDOW, 1);
 
 					CheckDoubleBuffer();
-
-					UpdateTitle();
-					XSync(display, false);
 				}
 
 				XlibWindow::~XlibWindow()
@@ -104,29 +111,73 @@ namespace vl
 					}
 				}
 
-				void XlibWindow::UpdateResizable()
+				void XlibWindow::InvalidateRect(Rect rect)
+				{
+					//A synthetic Expose goes through the event loop like a real one and does not clear the area
+					XEvent event;
+					memset(&event, 0, sizeof(event));
+					event.xexpose.type = Expose;
+					event.xexpose.display = display;
+					event.xexpose.window = window;
+					event.xexpose.x = rect.x1;
+					event.xexpose.y = rect.y1;
+					event.xexpose.width = rect.Width();
+					event.xexpose.height = rect.Height();
+					event.xexpose.count = 0;
+					XSendEvent(display, window, False, ExposureMask, &event);
+				}
+
+				void XlibWindow::UpdateSizeHints()
 				{
+					//Built from the local state instead of reading the current hints back from the server
 					XSizeHints *hints = XAllocSizeHints();
-					Size currentSize = GetClientSize();
-					XGetNormalHints(display, window, hints);
+					hints->flags = PMinSize | PMaxSize;
 					if(resizable)
-					{
-						hints->min_width = currentSize.x;
-						hints->min_height = currentSize.y;
-						hints->max_width = currentSize.x;
-						hints->max_height = currentSize.y;
-					}
-					else
 					{
 						hints->min_width = 0;
 						hints->min_height = 0;
 						hints->max_width = INT_MAX;
 						hints->max_height = INT_MAX;
 					}
-					XSetNormalHints(display, window, hints);
+					else
+					{
+						hints->min_width = clientSize.x;
+						hints->min_height = clientSize.y;
+						hints->max_width = clientSize.x;
+						hints->max_height = clientSize.y;
+					}
+					XSetWMNormalHints(display, window, hints);
 					XFree(hints);
 				}
 
+				void XlibWindow::UpdateMotifHints()
+				{
+					MotifWmHints hints;
+					memset(&hints, 0, sizeof(hints));
+
+					hints.flags = 1 << 1;
+					hints.decorations = customFrameMode ? 0 : 1;
+
+					XChangeProperty(display, window, XlibAtoms::_MOTIF_WM_HINTS, XlibAtoms::_MOTIF_WM_HINTS, 32, PropModeReplace, (unsigned char*) &hints, 5);
+				}
+
+				void XlibWindow::UpdateWindowType()
+				{
+					Atom type = parentWindow ? XlibAtoms::_NET_WM_WINDOW_TYPE_POPUP_MENU : XlibAtoms::_NET_WM_WINDOW_TYPE_NORMAL;
+					XChangeProperty(display, window, XlibAtoms::_NET_WM_WINDOW_TYPE, XA_ATOM, 32, PropModeReplace, (unsigned char*)&type, 1);
+				}
+
+				void XlibWindow::FlushPendingUpdates()
+				{
+					if(pendingUpdates == 0) return;
+
+					if(pendingUpdates & PendingTitle) UpdateTitle();
+					if(pendingUpdates & PendingSizeHints) UpdateSizeHints();
+					if(pendingUpdates & PendingMotifHints) UpdateMotifHints();
+					if(pendingUpdates & PendingWindowType) UpdateWindowType();
+					pendingUpdates = 0;
+				}
+
 				void XlibWindow::GetParentList(vl::collections::List<Window>& result)
 				{
 					XlibWindow* win = this;
@@ -176,7 +227,118 @@ namespace vl
 
 					GetBounds();
 					GetClientSize();
-					RedrawContent();
+				}
+
+				void XlibWindow::ExposeEvent(Rect rect)
+				{
+					//Rectangles covered by another one are dropped, too many are merged into their bounding box
+					for(vint i = exposedRects.Count() - 1; i >= 0; i--)
+					{
+						Rect exposed = exposedRects[i];
+						if(exposed.x1 <= rect.x1 && exposed.y1 <= rect.y1 && exposed.x2 >= rect.x2 && exposed.y2 >= rect.y2)
+						{
+							return;
+						}
+						if(rect.x1 <= exposed.x1 && rect.y1 <= exposed.y1 && rect.x2 >= exposed.x2 && rect.y2 >= exposed.y2)
+						{
+							exposedRects.RemoveAt(i);
+						}
+					}
+
+					if(exposedRects.Count() == MaxExposedRectCount)
+					{
+						FOREACH(Rect, exposed, exposedRects)
+						{
+							if(exposed.x1 < rect.x1) rect.x1 = exposed.x1;
+							if(exposed.y1 < rect.y1) rect.y1 = exposed.y1;
+							if(exposed.x2 > rect.x2) rect.x2 = exposed.x2;
+							if(exposed.y2 > rect.y2) rect.y2 = exposed.y2;
+						}
+						exposedRects.Clear();
+					}
+					exposedRects.Add(rect);
+				}
+
+				void XlibWindow::ConfigureEvent(const XConfigureEvent& event)
+				{
+					//Window managers send a synthetic ConfigureNotify in root coordinates when a framed window moves
+					if(event.send_event || !reparented)
+					{
+						bounds = Rect(Point(event.x, event.y), Size(event.width, event.height));
+					}
+					else
+					{
+						bounds = Rect(bounds.LeftTop(), Size(event.width, event.height));
+					}
+					clientSize = Size(event.width, event.height);
+					//Moves and restacking keep the content, only a new size needs the whole window painted
+					if(clientSize != configuredSize)
+					{
+						configuredSize = clientSize;
+						configurePending = true;
+					}
+					else
+					{
+						movePending = true;
+					}
+				}
+
+				void XlibWindow::ReparentEvent(Window parent)
+				{
+					reparented = parent != XDefaultRootWindow(display);
+				}
+
+				void XlibWindow::FlushPendingEvents()
+				{
+					if(configurePending)
+					{
+						//A resized window is painted as a whole
+						configurePending = false;
+						movePending = false;
+						exposedRects.Clear();
+						ResizeEvent(clientSize.x, clientSize.y);
+						RedrawContent();
+						return;
+					}
+
+					if(movePending)
+					{
+						movePending = false;
+						Rect newBound = bounds;
+						FOREACH(INativeWindowListener*, i, listeners)
+						{
+							i->Moving(newBound, false);
+							i->Moved();
+						}
+					}
+
+					if(exposedRects.Count() > 0)
+					{
+						CopyFrom(paintRegion, exposedRects);
+						exposedRects.Clear();
+						RedrawContent();
+						paintRegion.Clear();
+					}
+				}
+
+				const collections::List<Rect>& XlibWindow::GetPaintRegion()
+				{
+					return paintRegion;
+				}
+
+				XlibLatencyTracker& XlibWindow::GetLatencyTracker()
+				{
+					return latencyTracker;
+				}
+
+				Rect XlibWindow::GetScreenBounds()
+				{
+					return bounds;
+				}
+
+				bool XlibWindow::IsReparented()
+				{
+					return reparented;
 				}
 
 				void XlibWindow::MouseUpEvent(MouseButton button, NativeWindowMouseInfo info)
@@ -240,6 +402,31 @@ namespace vl
 					{
 						i->MouseMoving(info);
 					}
+					motionHistory.Clear();
+				}
+
+				void XlibWindow::AddMotionHistory(Point position)
+				{
+					if(motionHistoryEnabled)
+					{
+						motionHistory.Add(position);
+					}
+				}
+
+				bool XlibWindow::GetMotionHistoryEnabled()
+				{
+					return motionHistoryEnabled;
+				}
+
+				void XlibWindow::SetMotionHistoryEnabled(bool value)
+				{
+					motionHistoryEnabled = value;
+					motionHistory.Clear();
+				}
+
+				const collections::List<Point>& XlibWindow::GetMotionHistory()
+				{
+					return motionHistory;
 				}
 
 				void XlibWindow::MouseEnterEvent()
@@ -268,13 +455,24 @@ namespace vl
 					}
 				}
 
-				void XlibWindow::Show()
+				void XlibWindow::FocusEvent(const XFocusChangeEvent& event)
 				{
-					XMapWindow(display, window);
+					//Grabs and focus moving between this window and its children keep the keyboard focus here
+					if(event.mode == NotifyGrab || event.mode == NotifyUngrab) return;
+					if(event.detail == NotifyInferior || event.detail == NotifyPointer) return;
+					inputFocus = event.type == FocusIn;
+				}
 
-					visible = true;
-					SetBounds(bounds);
-					GetClientSize();
+				void XlibWindow::Show()
+				{
+					//Window managers read the hints when the window is mapped, the geometry is sent along in the same flush
+					FlushPendingUpdates();
+					if(!visible)
+					{
+						XMoveResizeWindow(display, window, bounds.x1, bounds.y1, bounds.Width(), bounds.Height());
+						XMapWindow(display, window);
+						visible = true;
+					}
 				}
 
 				void XlibWindow::Hide()
@@ -282,6 +480,7 @@ namespace vl
 					XUnmapWindow(display, window);
 
 					visible = false;
+					caretVisible = false;
 				}
 
 				Rect XlibWindow::GetBounds()
@@ -305,6 +504,11 @@ namespace vl
 				{
 					//TODO
 					this->bounds = bounds;
+					if(!resizable)
+					{
+						clientSize = bounds.GetSize();
+						pendingUpdates |= PendingSizeHints;
+					}
 					if(visible)
 						XMoveResizeWindow(display, window, bounds.x1, bounds.y1, bounds.Width(), bounds.Height());
 				}
@@ -324,6 +528,10 @@ namespace vl
 				void XlibWindow::SetClientSize(Size size)
 				{
 					clientSize = size;
+					if(!resizable)
+					{
+						pendingUpdates |= PendingSizeHints;
+					}
 					if(visible)
 						XResizeWindow(display, window, size.x, size.y);
 				}
@@ -342,7 +550,7 @@ namespace vl
 				void XlibWindow::SetTitle(WString title)
 				{
 					this->title = title;
-					UpdateTitle();
+					pendingUpdates |= PendingTitle;
 				}
 
 				INativeCursor *XlibWindow::GetWindowCursor()
@@ -358,13 +566,18 @@ namespace vl
 
 				Point XlibWindow::GetCaretPoint()
 				{
-					//TODO
-					return Point();
+					return caretPoint;
 				}
 
 				void XlibWindow::SetCaretPoint(Point point)
 				{
-					//TODO
+					caretPoint = point;
+					caretVisible = true;
+				}
+
+				bool XlibWindow::HasCaret()
+				{
+					return visible && inputFocus && caretVisible;
 				}
 
 				INativeWindow *XlibWindow::GetParent()
@@ -375,12 +588,7 @@ namespace vl
 				void XlibWindow::SetParent(INativeWindow *parent)
 				{
 					parentWindow = dynamic_cast<XlibWindow*>(parent);
-
-					if(parentWindow)
-					{
-						XChangeProperty(display, window, XlibAtoms::_NET_WM_WINDOW_TYPE, XlibAtoms::_NET_WM_WINDOW_TYPE, 32, PropModeReplace,
-								(unsigned char*)&XlibAtoms::_NET_WM_WINDOW_TYPE_POPUP_MENU, 1);
-					}
+					pendingUpdates |= PendingWindowType;
 				}
 
 				bool XlibWindow::GetAlwaysPassFocusToParent()
@@ -396,26 +604,14 @@ namespace vl
 
 				void XlibWindow::EnableCustomFrameMode()
 				{
-					MotifWmHints hints;
-
-					hints.flags = 1 << 1;
-					hints.decorations = 0;
-					
-					XChangeProperty(display, window, XlibAtoms::_MOTIF_WM_HINTS, XlibAtoms::_MOTIF_WM_HINTS, 32, PropModeReplace, (unsigned char*) &hints, 5);
-
 					customFrameMode = true;
+					pendingUpdates |= PendingMotifHints;
 				}
 
 				void XlibWindow::DisableCustomFrameMode()
 				{
-					MotifWmHints hints;
-
-					hints.flags = 1 << 1;
-					hints.decorations = 1;
-					
-					XChangeProperty(display, window, XlibAtoms::_MOTIF_WM_HINTS, XlibAtoms::_MOTIF_WM_HINTS, 32, PropModeReplace, (unsigned char*) &hints, 5);
-
 					customFrameMode = false;
+					pendingUpdates |= PendingMotifHints;
 				}
 
 				bool XlibWindow::IsCustomFrameModeEnabled()
@@ -587,7 +783,7 @@ namespace vl
 				void XlibWindow::SetSizeBox(bool visible)
 				{
 					resizable = visible;
-					UpdateResizable();
+					pendingUpdates |= PendingSizeHints;
 				}
 
 				bool XlibWindow::GetIconVisible()
@@ -3,6 +3,7 @@
 
 #include <GacUI.h>
 #include "XlibIncludes.h"
+#include "XlibLatencyTracker.h"
 #include "../Common/X11Window.h"
 
 namespace vl
@@ -26,12 +27,45 @@ namespace vl
 					XlibWindow* parentWindow;
 					Rect bounds;
 					Size clientSize;
+					bool motionHistoryEnabled;
+					//Set by the first SetCaretPoint, a text control has a caret blinking in this window.
+					//Without the keyboard focus the caret does not blink, the focus is assumed until the first FocusOut
+					Point caretPoint;
+					bool caretVisible;
+					bool inputFocus;
+					collections::List<Point> motionHistory;
+
+					//Exposed areas and the latest ConfigureNotify, handled once the event queue is drained
+					collections::List<Rect> exposedRects;
+					collections::List<Rect> paintRegion;
+					bool configurePending;
+					bool movePending;
+					//The size of the last ConfigureNotify, clientSize is also changed by the setters before the server agrees
+					Size configuredSize;
+					//True when a window manager put the window into a frame, ConfigureNotify positions are then frame relative
+					bool reparented;
+
+					XlibLatencyTracker latencyTracker;
+
+					//Properties changed since the last flush, each one is written once no matter how often it changed
+					enum PendingUpdate
+					{
+						PendingTitle = 1,
+						PendingSizeHints = 2,
+						PendingMotifHints = 4,
+						PendingWindowType = 8,
+					};
+					vint pendingUpdates;
 
 					void UpdateTitle();
-					void UpdateResizable();
+					void UpdateSizeHints();
+					void UpdateMotifHints();
+					void UpdateWindowType();
 					void GetParentList(collections::List<Window>&);
 
 				public:
+					static const vint MaxExposedRectCount = 16;
+
 					XlibWindow(Display *display);
 
 					virtual ~XlibWindow();
@@ -44,18 +78,43 @@ namespace vl
 					bool GetDoubleBuffer();
 					XdbeBackBuffer GetBackBuffer();
 					void SwapBuffer();
+					void InvalidateRect(Rect rect);
 
 					void SetRenderTarget(elements::IGuiGraphicsRenderTarget*);
 
 					elements::IGuiGraphicsRenderTarget* GetRenderTarget();
 
+					//Consecutive motion events are merged into one MouseMoving, with the skipped positions
+					//kept in order when enabled, they are only valid inside MouseMoving
+					bool GetMotionHistoryEnabled();
+					void SetMotionHistoryEnabled(bool value);
+					const collections::List<Point>& GetMotionHistory();
+
+					//The exposed areas being repainted, only valid inside Paint, empty when the whole window is painted
+					const collections::List<Rect>& GetPaintRegion();
+
+					//Input to frame latency of this window, for each kind of input event
+					XlibLatencyTracker& GetLatencyTracker();
+
+					//Bounds in root coordinates as of the latest ConfigureNotify, without asking the server
+					Rect GetScreenBounds();
+					bool IsReparented();
+
 					void MouseUpEvent(MouseButton button, NativeWindowMouseInfo info);
 					void MouseDownEvent(MouseButton button, NativeWindowMouseInfo info);
 					void MouseMoveEvent(NativeWindowMouseInfo info);
+					void AddMotionHistory(Point position);
 					void MouseEnterEvent();
 					void MouseLeaveEvent();
 					void ResizeEvent(int width, int height);
+					void ExposeEvent(Rect rect);
+					void ConfigureEvent(const XConfigureEvent& event);
+					void ReparentEvent(Window parent);
+					void FlushPendingEvents();
+					//Writes properties and hints changed since the last call, before mapping and once per loop iteration
+					void FlushPendingUpdates();
 					void VisibilityEvent(Window window);
+					void FocusEvent(const XFocusChangeEvent& event);
 
 					//GacUI Implementations
 					virtual Rect GetBounds();
@@ -79,6 +138,8 @@ namespace vl
 					virtual Point GetCaretPoint();
 
 					virtual void SetCaretPoint(Point point);
+					//True when the window is visible, focused and has a caret, which needs the global timer to blink
+					bool HasCaret();
 
 					virtual INativeWindow *GetParent();
 
@@ -0,0 +1,156 @@
+#include <string.h>
+#include <X11/extensions/XInput2.h>
+#include "XlibXInput2MouseHookHelper.h"
+
+namespace vl
+{
+	using namespace collections;
+	namespace presentation
+	{
+		namespace x11cairo
+		{
+			namespace xlib
+			{
+				XlibXInput2MouseHookHelper::XlibXInput2MouseHookHelper(Display* _display):
+					display(_display),
+					opcode(0),
+					available(false),
+					capturing(false),
+					motionPending(false)
+				{
+					int event, error;
+					if(XQueryExtension(display, "XInputExtension", &opcode, &event, &error))
+					{
+						int major = 2, minor = 0;
+						available = XIQueryVersion(display, &major, &minor) == XLIB_SUCCESS && major >= 2;
+					}
+				}
+
+				XlibXInput2MouseHookHelper::~XlibXInput2MouseHookHelper()
+				{
+					if(capturing) EndCapture();
+				}
+
+				void XlibXInput2MouseHookHelper::SelectEvents(bool enabled)
+				{
+					unsigned char mask[XIMaskLen(XI_LASTEVENT)];
+					memset(mask, 0, sizeof(mask));
+					if(enabled)
+					{
+						XISetMask(mask, XI_RawButtonPress);
+						XISetMask(mask, XI_RawButtonRelease);
+						XISetMask(mask, XI_RawMotion);
+					}
+
+					XIEventMask eventMask;
+					eventMask.deviceid = XIAllMasterDevices;
+					eventMask.mask_len = sizeof(mask);
+					eventMask.mask = mask;
+					XISelectEvents(display, XDefaultRootWindow(display), &eventMask, 1);
+					XFlush(display);
+				}
+
+				Point XlibXInput2MouseHookHelper::QueryPointer()
+				{
+					//Raw events carry no position
+					Window root, child;
+					int rootX = 0, rootY = 0, x, y;
+					unsigned int mask;
+					XQueryPointer(display, XDefaultRootWindow(display), &root, &child, &rootX, &rootY, &x, &y, &mask);
+					return Point(rootX, rootY);
+				}
+
+				bool XlibXInput2MouseHookHelper::IsAvailable()
+				{
+					return available;
+				}
+
+				bool XlibXInput2MouseHookHelper::HandleEvent(XEvent& event)
+				{
+					if(event.type != GenericEvent || event.xcookie.extension != opcode) return false;
+					if(!XGetEventData(display, &event.xcookie)) return true;
+
+					if(capturing)
+					{
+						XIRawEvent* raw = (XIRawEvent*)event.xcookie.data;
+						switch(event.xcookie.evtype)
+						{
+							case XI_RawButtonPress:
+							case XI_RawButtonRelease:
+								{
+									unsigned int code = raw->detail;
+									if(code >= 1 && code <= (unsigned int)buttonMapping.Count())
+									{
+										code = buttonMapping[code - 1];
+									}
+
+									MouseButton button;
+									if(XButtonCodeToButton(code, button))
+									{
+										Point position = QueryPointer();
+										MouseEventType type = event.xcookie.evtype == XI_RawButtonPress ? MouseEventType::BUTTONDOWN : MouseEventType::BUTTONUP;
+										hookEvents.Add(MouseEvent(button, type, position.x, position.y));
+									}
+								}
+								break;
+							case XI_RawMotion:
+								motionPending = true;
+								break;
+						}
+					}
+
+					XFreeEventData(display, &event.xcookie);
+					return true;
+				}
+
+				void XlibXInput2MouseHookHelper::ProcessEvents(const Func<void(MouseEvent)>& handler)
+				{
+					//All motion since the last call is reported once, at the current position
+					if(motionPending)
+					{
+						motionPending = false;
+						Point position = QueryPointer();
+						hookEvents.Add(MouseEvent(MouseButton::LBUTTON, MouseEventType::POINTERMOVE, position.x, position.y));
+					}
+
+					for(vint i = 0; i < hookEvents.Count(); i++)
+					{
+						handler(hookEvents[i]);
+					}
+					hookEvents.Clear();
+				}
+
+				void XlibXInput2MouseHookHelper::StartCapture()
+				{
+					if(!available || capturing) return;
+
+					unsigned char mapping[256];
+					int count = XGetPointerMapping(display, mapping, sizeof(mapping));
+					buttonMapping.Resize(count);
+					for(int i = 0; i < count; i++)
+					{
+						buttonMapping[i] = mapping[i];
+					}
+
+					SelectEvents(true);
+					capturing = true;
+				}
+
+				void XlibXInput2MouseHookHelper::EndCapture()
+				{
+					if(!capturing) return;
+
+					SelectEvents(false);
+					capturing = false;
+					motionPending = false;
+					hookEvents.Clear();
+				}
+
+				bool XlibXInput2MouseHookHelper::IsCapturing()
+				{
+					return capturing;
+				}
+			}
+		}
+	}
+}
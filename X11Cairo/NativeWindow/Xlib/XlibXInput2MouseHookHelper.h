@@ -0,0 +1,49 @@
+#ifndef __GAC_X11CAIRO_XLIB_XINPUT2_MOUSE_HOOK_HELPER_H
+#define __GAC_X11CAIRO_XLIB_XINPUT2_MOUSE_HOOK_HELPER_H
+
+#include <GacUI.h>
+#include "XlibIncludes.h"
+
+namespace vl
+{
+	namespace presentation
+	{
+		namespace x11cairo
+		{
+			namespace xlib
+			{
+				//Selects XI2 raw pointer events on the root window of the main connection while capturing,
+				//the event loop passes GenericEvent to HandleEvent
+				class XlibXInput2MouseHookHelper: public Object, public IXlibMouseHookHelper
+				{
+				protected:
+					Display* display;
+					int opcode;
+					bool available;
+					bool capturing;
+					collections::List<MouseEvent> hookEvents;
+					bool motionPending;
+					//Raw events report physical buttons, this is the pointer mapping read when capturing starts
+					collections::Array<unsigned char> buttonMapping;
+
+					void SelectEvents(bool enabled);
+					Point QueryPointer();
+
+				public:
+					XlibXInput2MouseHookHelper(Display* _display);
+					~XlibXInput2MouseHookHelper();
+
+					bool IsAvailable();
+					bool HandleEvent(XEvent& event);
+
+					void ProcessEvents(const Func<void(MouseEvent)>& handler)override;
+					void StartCapture()override;
+					void EndCapture()override;
+					bool IsCapturing()override;
+				};
+			}
+		}
+	}
+}
+
+#endif
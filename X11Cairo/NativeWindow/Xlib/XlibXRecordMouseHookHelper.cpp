@@ -1,3 +1,7 @@
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
 #include "XlibXRecordMouseHookHelper.h"
 
 namespace vl
@@ -9,13 +13,47 @@ namespace vl
 		{
 			namespace xlib
 			{
-				XlibXRecordMouseHookHelper::XlibXRecordMouseHookHelper(const char* connString):
-					ctrlDisplay(NULL), dataDisplay(NULL), capturing(false)
+				XlibXRecordMouseHookHelper::XlibXRecordMouseHookHelper(const char* connString, const Func<void()>& _eventsArrived):
+					connectionString(connString),
+					recordContext(0),
+					ctrlDisplay(NULL),
+					dataDisplay(NULL),
+					capturing(false),
+					eventsArrived(_eventsArrived),
+					thread(NULL),
+					recordStarted(false),
+					recordEnded(false),
+					stopRequested(false),
+					recordDisabled(false),
+					ringHead(0),
+					ringTail(0),
+					droppedEventCount(0)
 				{
-					hookEvents.SetLessMemoryMode(false);
+					stopFds[0] = stopFds[1] = -1;
+				}
+
+				XlibXRecordMouseHookHelper::~XlibXRecordMouseHookHelper()
+				{
+					if(capturing) EndCapture();
+					if(recordContext)
+					{
+						XRecordFreeContext(ctrlDisplay, recordContext);
+					}
+					if(ctrlDisplay) XCloseDisplay(ctrlDisplay);
+					if(dataDisplay) XCloseDisplay(dataDisplay);
+					if(stopFds[0] != -1)
+					{
+						close(stopFds[0]);
+						close(stopFds[1]);
+					}
+				}
+
+				bool XlibXRecordMouseHookHelper::Open()
+				{
+					if(recordContext) return true;
 
-					ctrlDisplay = XOpenDisplay(connString);
-					dataDisplay = XOpenDisplay(connString);
+					ctrlDisplay = XOpenDisplay(connectionString.Buffer());
+					dataDisplay = XOpenDisplay(connectionString.Buffer());
 
 					if(!ctrlDisplay || !dataDisplay)
 					{
@@ -26,6 +64,12 @@ namespace vl
 					{
 						throw Exception(L"Record Extension is required for GacUI/X11.");
 					}
+
+					if(pipe(stopFds))
+					{
+						throw Exception(L"Unable to create the mouse hook pipe.");
+					}
+					fcntl(stopFds[0], F_SETFL, fcntl(stopFds[0], F_GETFL) | O_NONBLOCK);
 					
 					// Initialize X Record Extension
 					XRecordClientSpec recordClientSpec = XRecordAllClients;
@@ -36,28 +80,28 @@ namespace vl
 					XSynchronize(ctrlDisplay, XLIB_TRUE);
 					recordContext = XRecordCreateContext(ctrlDisplay, XRecordFromClientTime, &recordClientSpec, 1, &recordRange, 1);
 					XFree(recordRange);
+					return recordContext != 0;
 				}
 
-				XlibXRecordMouseHookHelper::~XlibXRecordMouseHookHelper()
-				{
-					if(capturing) EndCapture();
-					XRecordFreeContext(ctrlDisplay, recordContext);
-					XFlush(dataDisplay);
-					XCloseDisplay(ctrlDisplay);
-					XCloseDisplay(dataDisplay);
-				}
-
-				void XlibXRecordMouseHookHelper::StartCapture()
+				void XlibXRecordMouseHookHelper::Run()
 				{
 					XRecordEnableContextAsync(
 							dataDisplay, 
 							recordContext, 
 							[](XPointer closure, XRecordInterceptData *recorded_data)
 							{
-								if(recorded_data->category == XRecordFromServer)
+								XlibXRecordMouseHookHelper* helper = (XlibXRecordMouseHookHelper*) closure;
+								if(recorded_data->category == XRecordStartOfData)
+								{
+									helper->RecordStateChanged(true);
+								}
+								else if(recorded_data->category == XRecordEndOfData)
+								{
+									helper->RecordStateChanged(false);
+								}
+								else if(recorded_data->category == XRecordFromServer)
 								{
 									xEvent *data = (xEvent *) recorded_data->data;
-									XlibXRecordMouseHookHelper* helper = (XlibXRecordMouseHookHelper*) closure;
 									switch(data->u.u.type)
 									{
 									case ButtonPress:
@@ -70,14 +114,85 @@ namespace vl
 								XRecordFreeData(recorded_data);
 							}, 
 							(XPointer) this);
-
 					XFlush(dataDisplay);
+
+					bool stopping = false;
+					while(!recordEnded)
+					{
+						struct pollfd fds[2];
+						fds[0].fd = ConnectionNumber(dataDisplay);
+						fds[0].events = POLLIN;
+						fds[1].fd = stopFds[0];
+						fds[1].events = POLLIN;
+						fds[1].revents = 0;
+						poll(fds, stopping ? 1 : 2, -1);
+
+						vint tail = ringTail;
+						XRecordProcessReplies(dataDisplay);
+						if(ringTail != tail)
+						{
+							eventsArrived();
+						}
+
+						if(!stopping && ((fds[1].revents & POLLIN) || __atomic_load_n(&stopRequested, __ATOMIC_ACQUIRE)))
+						{
+							char buffer[16];
+							while(read(stopFds[0], buffer, sizeof(buffer)) > 0);
+							stopping = true;
+						}
+
+						//Disabling before the server starts the context would leave it enabled forever,
+						//the loop ends when the server confirms with XRecordEndOfData
+						if(stopping && recordStarted && !recordEnded)
+						{
+							DisableRecord();
+						}
+					}
+				}
+
+				void XlibXRecordMouseHookHelper::DisableRecord()
+				{
+					bool expected = false;
+					if(__atomic_compare_exchange_n(&recordDisabled, &expected, true, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+					{
+						XRecordDisableContext(ctrlDisplay, recordContext);
+					}
+				}
+
+				void XlibXRecordMouseHookHelper::StartCapture()
+				{
+					if(capturing || !Open()) return;
+
+					recordStarted = false;
+					recordEnded = false;
+					stopRequested = false;
+					recordDisabled = false;
 					capturing = true;
+					thread = Thread::CreateAndStart([this](){ Run(); }, false);
 				}
 
 				void XlibXRecordMouseHookHelper::EndCapture()
 				{
-					XRecordDisableContext(ctrlDisplay, recordContext);
+					if(!capturing) return;
+
+					__atomic_store_n(&stopRequested, true, __ATOMIC_RELEASE);
+					char stop = 0;
+					ssize_t written = 0;
+					do
+					{
+						written = write(stopFds[1], &stop, 1);
+					}
+					while(written == -1 && errno == EINTR);
+
+					//Without the wakeup the record thread still runs once data arrives, disabling the context makes
+					//the server send XRecordEndOfData. A context not started yet is disabled by the record thread itself
+					if(written != 1 && __atomic_load_n(&recordStarted, __ATOMIC_ACQUIRE))
+					{
+						DisableRecord();
+					}
+					thread->Wait();
+					delete thread;
+					thread = NULL;
 					capturing = false;
 				}
 
@@ -86,56 +201,77 @@ namespace vl
 					return capturing;
 				}
 
-				void XlibXRecordMouseHookHelper::Update()
+				vint XlibXRecordMouseHookHelper::GetDroppedEventCount()
+				{
+					return droppedEventCount;
+				}
+
+				void XlibXRecordMouseHookHelper::RecordStateChanged(bool started)
 				{
-					XRecordProcessReplies(dataDisplay);
+					if(started)
+					{
+						recordStarted = true;
+					}
+					else
+					{
+						recordEnded = true;
+					}
 				}
 
-				MouseEvent XlibXRecordMouseHookHelper::DataToEvent(xEvent* ev)
+				bool XlibXRecordMouseHookHelper::DataToEvent(xEvent* ev, MouseEvent& event)
 				{
+					//The detail of button events is the button number, the state mask only holds the buttons pressed before
 					MouseEventType type;
-					MouseButton button;
+					MouseButton button = MouseButton::LBUTTON;
 					switch(ev->u.u.type)
 					{
 						case ButtonPress:
 							type = MouseEventType::BUTTONDOWN;
+							if(!XButtonCodeToButton(ev->u.u.detail, button)) return false;
 							break;
 						case ButtonRelease:
 							type = MouseEventType::BUTTONUP;
+							if(!XButtonCodeToButton(ev->u.u.detail, button)) return false;
 							break;
-						case MotionNotify:
+						default:
 							type = MouseEventType::POINTERMOVE;
 							break;
 					}
 
-					if(ev->u.keyButtonPointer.state & Button2Mask)
-					{
-						button = MouseButton::RBUTTON;
-					}
-					else
-					{
-						button = MouseButton::LBUTTON;
-					}
-
-					return MouseEvent(button, type, ev->u.keyButtonPointer.rootX, ev->u.keyButtonPointer.rootY);
+					event = MouseEvent(button, type, ev->u.keyButtonPointer.rootX, ev->u.keyButtonPointer.rootY);
+					return true;
 				}
 
-				void XlibXRecordMouseHookHelper::AddData(xEvent* ev)
+				bool XlibXRecordMouseHookHelper::AddData(xEvent* ev)
 				{
-					hookEvents.Add(DataToEvent(ev));
+					//Called on the record thread, the slot is filled before the new tail is published
+					MouseEvent event;
+					if(!DataToEvent(ev, event)) return false;
+
+					vint tail = ringTail;
+					vint next = (tail + 1) % RingSize;
+					if(next == __atomic_load_n(&ringHead, __ATOMIC_ACQUIRE))
+					{
+						droppedEventCount++;
+						return false;
+					}
+
+					ring[tail] = event;
+					__atomic_store_n(&ringTail, next, __ATOMIC_RELEASE);
+					return true;
 				}
 
-				void XlibXRecordMouseHookHelper::ProcessEvents(Func<void(MouseEvent)> handler)
+				void XlibXRecordMouseHookHelper::ProcessEvents(const Func<void(MouseEvent)>& handler)
 				{
-					Array<MouseEvent> currentEvents(hookEvents.Count());
-				   	CopyFrom(currentEvents, hookEvents);
-
-					FOREACH(MouseEvent, i, currentEvents)
+					vint head = ringHead;
+					vint tail = __atomic_load_n(&ringTail, __ATOMIC_ACQUIRE);
+					while(head != tail)
 					{
-						handler(i);
+						MouseEvent event = ring[head];
+						head = (head + 1) % RingSize;
+						__atomic_store_n(&ringHead, head, __ATOMIC_RELEASE);
+						handler(event);
 					}
-
-					hookEvents.Clear();
 				}
 			}
 		}
@@ -20,26 +20,51 @@ namespace vl
 		{
 			namespace xlib
 			{
-				class XlibXRecordMouseHookHelper: public Object
+				//Records mouse events of all clients on a dedicated thread, only while capturing.
+				//Connections are opened by the first StartCapture.
+				class XlibXRecordMouseHookHelper: public Object, public IXlibMouseHookHelper
 				{
 				protected:
-					vl::collections::List<MouseEvent> hookEvents;
+					static const vint RingSize = 1024;
+
+					AString connectionString;
 					XRecordContext recordContext;
 					Display *ctrlDisplay, *dataDisplay;
 					bool capturing;
+					Func<void()> eventsArrived;
+
+					Thread* thread;
+					int stopFds[2];
+					//Written by the record thread, recordStarted is also read by EndCapture
+					volatile bool recordStarted;
+					bool recordEnded;
+					//Set by EndCapture before it writes to stopFds, so a record thread woken by data also stops
+					volatile bool stopRequested;
+					//The context is disabled by the first thread that gets here, see DisableRecord
+					bool recordDisabled;
+
+					//Written only by the record thread (ringTail) or only by the main thread (ringHead)
+					MouseEvent ring[RingSize];
+					volatile vint ringHead;
+					volatile vint ringTail;
+					volatile vint droppedEventCount;
 
-					MouseEvent DataToEvent(xEvent* ev);
+					bool Open();
+					void Run();
+					void DisableRecord();
+					bool DataToEvent(xEvent* ev, MouseEvent& event);
 
 				public:
-					XlibXRecordMouseHookHelper(const char*);
+					XlibXRecordMouseHookHelper(const char*, const Func<void()>& _eventsArrived);
 					~XlibXRecordMouseHookHelper();
-					void Update();
-					void ProcessEvents(Func<void(MouseEvent)>);
-					void StartCapture();
-					void EndCapture();
-					bool IsCapturing();
+					void ProcessEvents(const Func<void(MouseEvent)>& handler)override;
+					void StartCapture()override;
+					void EndCapture()override;
+					bool IsCapturing()override;
+					vint GetDroppedEventCount();
 
-					void AddData(xEvent* ev);
+					bool AddData(xEvent* ev);
+					void RecordStateChanged(bool started);
 				};
 			}
 		}
@@ -1,6 +1,7 @@
 #include "X11CairoSetup.h"
 #include "GraphicsElement/X11CairoResourceManager.h"
 #include "GraphicsElement/GuiGraphicsX11Cairo.h"
+#include "GraphicsElement/X11CairoFontWarmUp.h"
 #include <locale.h>
 
 #ifndef GAC_X11_XCB
@@ -12,12 +13,15 @@ void SetupX11CairoRenderer(const char* displayname)
 
 	INativeController* controller = vl::presentation::x11cairo::xlib::CreateXlibCairoNativeController(displayname);
 	SetCurrentController(controller);
+	vl::presentation::elements_x11cairo::StartX11CairoFontWarmUp();
 
 	vl::presentation::x11cairo::RegisterX11CairoResourceManager();
 	vl::presentation::elements_x11cairo::RegisterX11CairoElementRenderers(); 
 
 	vl::presentation::x11cairo::xlib::X11CairoMain();
 
+	vl::presentation::elements_x11cairo::StopX11CairoFontWarmUp();
+
 	vl::presentation::x11cairo::UnregisterX11CairoResourceManager();
 	SetCurrentController(NULL);
 	vl::presentation::x11cairo::xlib::DestroyXlibCairoNativeController(controller);